@@ -11,6 +11,17 @@ Iván Ballesteros Fernández - 24-25 - 2ºGCIA
 #include <errno.h>    // Para manejar errores del sistema
 #include "job_control.h" // Biblioteca personalizada para control de trabajos
 #include "parse_redir.h" // Biblioteca personalizada para parsear redirecciones
+#include "dag.h" // Planificador de trabajos con dependencias (after, dag)
+#include "deferred.h" // Cola de lanzamientos diferidos (delay-thread, every)
+#include "zygote.h" // Lanzador precalentado
+#include "fastcmd.h" // Utilidades triviales ejecutadas sin fork
+#include "tokenizer.h" // Separación de la línea en argumentos (comillas y escapes)
+#include "vars.h" // Variables del shell y entorno de los hijos
+#include "jobtop.h" // Consumo de recursos de los trabajos
+#include "jobspec.h" // Selección de trabajos para kill, stop y cont
+#include "parmap.h" // Un comando por cada elemento de la entrada, en paralelo
+#include "health.h" // Comprobaciones de vida de los trabajos respawnable
+#include "memo.h" // Caché de la salida de comandos deterministas
 #include "pthread.h" // Biblioteca para trabajar con hilos
 #include "time.h"   // Para trabajar con el tiempo"
 
@@ -44,7 +55,7 @@ void sighup_handler(int sig) {
  */
 void sigchld_handler(int sig) {
     int pid_c, pid_resp;
-    int wstatus, info, grupo;
+    int wstatus, info;
     job *tarea;
 
     block_SIGCHLD(); // Bloquear señales SIGCHLD para evitar condiciones de carrera
@@ -53,6 +64,14 @@ void sigchld_handler(int sig) {
 
         // Obtener el estado del proceso
         int status_res = analyze_status(wstatus, &info);
+        if (pid_c == zygote_pid() && (status_res == EXITED || status_res == SIGNALED)) {
+            zygote_exited(); // El lanzador no es un trabajo: a partir de ahora se usa fork
+            continue;
+        }
+        if (foreground_reaped(pid_c, wstatus)) continue; // Lo espera wait_foreground
+        if (parmap_child_exited(pid_c, wstatus)) continue; // Hijo de parmap: lanza el siguiente elemento
+        if (health_child_exited(pid_c, wstatus)) continue; // Orden de prueba de health
+        if (memo_child_exited(pid_c, wstatus)) continue; // Copia de la salida de un memo suspendido
         tarea = get_item_bypid(job_list, pid_c);
 
         if (tarea == NULL) {
@@ -63,33 +82,31 @@ void sigchld_handler(int sig) {
         // Imprimir información del proceso
         if (status_res != CONTINUED) {
             printf(VERDE "%s process %d finished: %s\n" RESET,state_strings[tarea->state], pid_c, status_strings[status_res]);
+            if (status_res == SIGNALED && info == SIGXCPU) { // Agotó el límite de CPU de ulimit
+                printf(MARRON "Process %d (%s) hit its CPU time limit\n" RESET, pid_c, tarea->command);
+            }
             fflush(stdout);
         }
 
         if (status_res == SUSPENDED) { 
             // Si el proceso se suspende, actualizar su estado
-            tarea->state = STOPPED;
+            set_job_state(job_list, tarea, STOPPED);
 
         } else if (status_res == EXITED || status_res == SIGNALED) {
             if (tarea->state == RESPAWNABLE) {
                 // Relanzar el proceso respawnable
-                pid_resp = fork();
+                int hung = health_was_hung(tarea, pid_c); // Lo mató health por no responder
+                if (hung) tarea->hang_restarts++;
+                else tarea->crash_restarts++;
+                pid_resp = spawn_job(tarea->args, &tarea->opts, health_redirs(tarea));
                 if (pid_resp == -1) {
                     perror(ROJO "Error: No se pudo relanzar el proceso respawnable\n" RESET);
-                } else if (pid_resp == 0) { // Proceso hijo
-                    grupo = getpid();
-                    setpgid(pid_resp, grupo);
-                    restore_terminal_signals(); // Restaurar señales predeterminadas
-                    printf(VERDE "Respawnable job relaunched: command: %s, new pid: %d\n" RESET,
-                           tarea->command, grupo);
+                } else {
+                    set_job_pgid(job_list, tarea, pid_resp); // Actualizar el PGID del trabajo
+                    printf(VERDE "Respawnable job relaunched%s: command: %s, new pid: %d\n" RESET,
+                           hung ? " (hang)" : "", tarea->command, pid_resp);
                     printf(AZUL "COMMAND->" RESET);
                     fflush(stdout);
-                    execvp(tarea->command, tarea->args);
-                    perror(ROJO "execvp failed in respawnable job" RESET);
-                    exit(EXIT_FAILURE);
-                } else { // Proceso padre
-                    setpgid(pid_resp, pid_resp);
-                    tarea->pgid = pid_resp; // Actualizar el PGID del trabajo
                 }
             } else {
                 // Eliminar el trabajo si no es respawnable
@@ -97,11 +114,13 @@ void sigchld_handler(int sig) {
                 if (delete_job(job_list, tarea) != 1) {
                     printf(ROJO "Error: No se pudo eliminar la tarea con PID %d\n" RESET, pid_c);
                 }
+                // Lanzar los trabajos que esperaban a este (after, dag)
+                dag_job_finished(job_list, pid_c, status_res == EXITED && info == 0);
             }
 
         } else if (status_res == CONTINUED) { 
             // Si el proceso continúa, actualizar su estado
-            tarea->state = BACKGROUND;
+            set_job_state(job_list, tarea, BACKGROUND);
         }
     }
     unblock_SIGCHLD(); // Desbloquear señales SIGCHLD
@@ -129,23 +148,42 @@ void *alarm_thread(void *arg) {
     return NULL;
 }
 
-// Función para el delay-thread
-void *delay_thread(void *arg) {
-    ThreadArgs *args = (ThreadArgs *) arg;  // Convertimos el argumento a la estructura
-    printf(MARRON "Delay activado: %d segundos\n" RESET, args->tiempo);  // Informamos al usuario
-    fflush(stdout);
-    sleep(args->tiempo);  // Esperamos el tiempo especificado
-    free(args);  // Liberamos la memoria de los argumentos
-    return NULL;
+
+// Imprime el tiempo transcurrido desde start_time (etime)
+void print_etime(struct timespec *start_time) {
+    struct timespec end_time;
+    if (clock_gettime(CLOCK_MONOTONIC, &end_time) == -1) { // Medir el tiempo de ejecución
+        perror(ROJO "Error: clock_gettime failed\n" RESET);
+    }
+    long int segundos = end_time.tv_sec - start_time->tv_sec; // Calcular el tiempo de ejecución
+    long int nanosegundos = end_time.tv_nsec - start_time->tv_nsec;
+    if (nanosegundos < 0) { // Corregir si los nanosegundos son negativos
+        segundos--;
+        nanosegundos += 1000000000;
+    }
+    printf(MARRON "Tiempo de ejecución: %ld.%09ld segundos\n" RESET, segundos, nanosegundos);
+}
+
+// Lanza los comandos programados (delay-thread, every) que han vencido mientras
+// el shell esperaba una orden y vuelve a mostrar el prompt
+void run_deferred(void) {
+    if (deferred_run() > 0) {
+        printf(AZUL "COMMAND->" RESET);
+        fflush(stdout);
+    }
 }
 
 
-int main(void)
+int main(int argc, char *argv[])
 {
+    if (argc == 3 && strcmp(argv[1], ZYGOTE_ARG) == 0) { // Copia del shell arrancada como lanzador
+        return zygote_serve(atoi(argv[2]));
+    }
+
     char inputBuffer[MAX_LINE]; /* Buffer para almacenar el comando introducido */
     int background = 0;             /* Indica si un comando debe ejecutarse en segundo plano (&) */
     int respawnable = 0;            /* Indica si un comando debe revivir al morir (+) */
-    char *args[MAX_LINE/2];     /* Lista de argumentos del comando */
+    char **args;                /* Lista de argumentos del comando (tras expandir comodines) */
 
     // Variables para el control de procesos
     int pid_fork, pid_wait, bg_fork; /* PIDs para el proceso creado y esperado */
@@ -155,18 +193,18 @@ int main(void)
     int pid_shell = getpid(); /* PID del proceso principal (shell) */
 
     int etime = 0; // Indica si se ha introducido etime
-    struct timespec start_time, end_time; // Variables para medir el tiempo de ejecución
+    struct timespec start_time; // Instante de inicio para medir el tiempo de ejecución
 
     int thread = 0; // Indica si se ha creado un hilo para el temporizador
-    int delay = 0; // Indica si se ha introducido delay-thread
+    int delay = 0; // Indica si se ha introducido delay-thread o every
     int seconds = 0; // Tiempo de vida del proceso
     int delay_seconds = 0; // Tiempo de espera del proceso
-
-    int mask = 0; // Indica si se ha introducido mask
-    int tam = 0; // Tamaño de los argumentos de mask
-    char *mask_args[MAX_LINE/2]; // Array para almacenar los argumentos de mask
+    int period = 0; // Periodo de relanzamiento de every (0 si es delay-thread)
 
     int bgt = 0; // Indica si se ha introducido bgteam
+    int team = 0; // Id del equipo del último bgteam
+    launch_opts lopts; // Opciones de planificación (sched, bgteam) para el hijo
+    health_opts hopts; // Comprobaciones de vida pedidas con health
     pthread_t tid; // Identificador del hilo
 	pthread_attr_t attr; // Atributos del hilo
 	pthread_attr_init(&attr); // Inicializar los atributos del hilo
@@ -175,6 +213,9 @@ int main(void)
 
     // Inicializar la lista de trabajos
     job_list = new_list("Lista de trabajos");
+    deferred_init(job_list); // Registra también el manejador de SIGALRM
+    set_input_wakeup(deferred_fd(), run_deferred); // Los programados se lanzan mientras se espera una orden
+    vars_init(); // Variables del shell a partir del entorno recibido
 
     // Registrar el manejador para la señal SIGCHLD
     signal(SIGCHLD, sigchld_handler);
@@ -191,13 +232,15 @@ int main(void)
         fflush(stdout); // Asegurar que el prompt se imprime inmediatamente
 
         // Obtener el comando del usuario
-        get_command(inputBuffer, MAX_LINE, args, &background, &respawnable);
+        get_command(inputBuffer, MAX_LINE, &args, &background, &respawnable);
+        init_launch_opts(&lopts); // Por defecto el hijo hereda la planificación del shell
+        init_health_opts(&hopts);
 
         if (args[0] == NULL) continue; /* Ignorar comandos vacíos */
 
         // Parseamos las redirecciones de entrada y salida
-        char *file_in, *file_out;
-        parse_redirections(args, &file_in, &file_out);
+        redir_list redirs;
+        parse_redirections(args, tokenize_literal(), &redirs);
 
         if (args[0] == NULL) {
             fprintf(stderr, ROJO "syntax error in redirection\n" RESET);
@@ -209,7 +252,7 @@ int main(void)
         // Comando interno: cambiar de directorio (cd)
         if (strcmp(args[0], "cd") == 0) {
             if (args[1] == NULL) {
-                if (chdir(getenv("HOME"))) { // Cambiar al directorio HOME
+                if (var_get("HOME") == NULL || chdir(var_get("HOME"))) { // Cambiar al directorio HOME
                     printf(ROJO "Error: No se pudo cambiar al directorio HOME\n" RESET);
                 }
             } else {
@@ -220,6 +263,49 @@ int main(void)
             continue; // Volver al inicio del bucle principal
         }
 
+        // Asignación de variables: NOMBRE=valor [NOMBRE=valor ...]
+        if (var_assignment(args[0])) {
+            int k = 0;
+            while (args[k] && var_assignment(args[k])) k++;
+            if (args[k] != NULL) {
+                printf(ROJO "Error: asignaciones seguidas de un comando no soportadas\n" RESET);
+                continue;
+            }
+            for (k = 0; args[k]; k++) {
+                args[k][var_assignment(args[k])] = '\0';
+                var_set(args[k], args[k] + strlen(args[k]) + 1, 0);
+            }
+            continue;
+        }
+
+        // Comando interno: exportar variables a los procesos lanzados (export)
+        // export [NOMBRE[=valor] ...]; sin argumentos lista las exportadas
+        if (strcmp(args[0], "export") == 0) {
+            if (args[1] == NULL) vars_print(1);
+            for (int k = 1; args[k]; k++) {
+                int len = var_assignment(args[k]);
+                if (len) args[k][len] = '\0';
+                if (var_set(args[k], len ? args[k] + len + 1 : NULL, 1) == -1) {
+                    printf(ROJO "export: nombre no válido: %s\n" RESET, args[k]);
+                }
+            }
+            continue;
+        }
+
+        // Comando interno: eliminar variables (unset)
+        if (strcmp(args[0], "unset") == 0) {
+            for (int k = 1; args[k]; k++) {
+                if (var_unset(args[k]) == -1) printf(ROJO "unset: nombre no válido: %s\n" RESET, args[k]);
+            }
+            continue;
+        }
+
+        // Comando interno: listar las variables del shell (set)
+        if (strcmp(args[0], "set") == 0 && args[1] == NULL) {
+            vars_print(0);
+            continue;
+        }
+
         // Comando interno: contador de tiempo de ejecución (etime)
         if(strcmp(args[0], "etime") == 0) { 
 			if (args[1] == NULL) { // Si no se especifica un comando, informamos y continuamos
@@ -236,17 +322,48 @@ int main(void)
 		}
 
         // Comando interno: mostrar la lista de trabajos (jobs)
+        // jobs -c id cancela el lanzamiento programado [Did]
 		if (strcmp(args[0], "jobs") == 0) {
+            if (args[1] != NULL) {
+                if (strcmp(args[1], "-c") != 0 || args[2] == NULL || atoi(args[2]) <= 0) {
+                    printf(ROJO "jobs: Argumento inválido\n" RESET);
+                } else if (!deferred_cancel(atoi(args[2]))) {
+                    printf(ROJO "jobs: no existe el lanzamiento programado D%s\n" RESET, args[2]);
+                } else {
+                    printf(VERDE "Lanzamiento programado D%s cancelado\n" RESET, args[2]);
+                }
+                continue;
+            }
 			block_SIGCHLD(); // Bloqueamos las señales SIGCHLD para evitar condiciones de carrera
-			if (empty_list(job_list)) { // Si la lista esta vacia, imprimimos que no hay tareas
+			if (empty_list(job_list) && deferred_count() == 0) { // Si la lista esta vacia, imprimimos que no hay tareas
 				printf(ROJO "No hay tareas en segundo plano o suspendidas.\n" RESET);
 			} else {
-				print_job_list(job_list); // Imprimimos la lista de tareas
+				if (!empty_list(job_list)) print_job_list(job_list); // Imprimimos la lista de tareas
+				deferred_print(); // y los lanzamientos que aún no han vencido
 			}
 			unblock_SIGCHLD(); // Desbloqueamos las señales SIGCHLD
 			continue; // Volver al inicio del bucle principal
         }
 
+        // Comando interno: consumo de recursos de los trabajos (jobtop)
+        // jobtop [-d segundos] [-n refrescos] [-s columna]; sin -n se refresca hasta pulsar q
+        if (strcmp(args[0], "jobtop") == 0) {
+            double interval = 1.0;
+            int iterations = 0, col = COL_CPU, k;
+            for (k = 1; args[k] && args[k + 1]; k += 2) {
+                if (strcmp(args[k], "-d") == 0 && atof(args[k + 1]) > 0) interval = atof(args[k + 1]);
+                else if (strcmp(args[k], "-n") == 0 && atoi(args[k + 1]) > 0) iterations = atoi(args[k + 1]);
+                else if (strcmp(args[k], "-s") == 0 && (col = jobtop_parse_col(args[k + 1])) >= 0) continue;
+                else break;
+            }
+            if (args[k] != NULL) {
+                printf(ROJO "jobtop: Argumento inválido (columnas: pgid state cpu rss threads read write command)\n" RESET);
+            } else {
+                jobtop(job_list, interval, iterations, col);
+            }
+            continue;
+        }
+
         // Comando interno: mostrar el trabajo actual (currjob)
         if (strcmp(args[0], "currjob") == 0) {
             if (args[1] != NULL) {
@@ -271,20 +388,54 @@ int main(void)
         }
 
         // Comando interno: lanzar n veces el comando en bacground (bgteam)
+        // bgteam [-n nice] [-p other|batch|idle] [-io clase[:nivel]] N comando
         if (strcmp(args[0], "bgteam") == 0) {
-            if (args[1] == NULL) {
+            int k = 1, res = 0;
+            while (args[k] && (res = parse_launch_opt(args, &k, &lopts)) == 1); // Opciones de planificación
+            if (args[k] == NULL || res == -1) {
                 printf(ROJO "bgteam: Argumento inválido\n" RESET);
                 continue; // Argumento inválido, volver al bucle principal
             }
-            if (atoi(args[1]) <= 0) {
+            if (atoi(args[k]) <= 0) {
                 printf(ROJO "bgteam: Argumento inválido\n" RESET);
                 continue; // Argumento inválido, volver al bucle principal
             }
-            bgt = atoi(args[1]); // Convertimos el argumento a entero
+            bgt = atoi(args[k]); // Convertimos el argumento a entero
             // Reformateamos los argumentos para que el comando se ejecute correctamente
-            for (int i = 2; args[i - 2]; i++) {
-                args[i - 2] = args[i];
+            for (int i = k + 1; args[i - (k + 1)]; i++) {
+                args[i - (k + 1)] = args[i];
+            }
+        }
+
+        // Comando interno: ejecutar el comando para cada línea de la entrada (parmap)
+        // parmap [-j K] [-k] [-a fichero] comando [args con {}] [< elementos] [> salida]
+        if (strcmp(args[0], "parmap") == 0) {
+            int k = 1, jobs = (int) sysconf(_SC_NPROCESSORS_ONLN), ordered = 0;
+            char *path = NULL;
+            while (args[k] && args[k][0] == '-') {
+                if (strcmp(args[k], "-k") == 0) {
+                    ordered = 1; // La salida sale en el orden de la entrada
+                    k++;
+                } else if (strcmp(args[k], "-j") == 0 && args[k + 1]) {
+                    jobs = atoi(args[k + 1]);
+                    k += 2;
+                } else if (strcmp(args[k], "-a") == 0 && args[k + 1]) {
+                    path = args[k + 1];
+                    k += 2;
+                } else {
+                    break;
+                }
+            }
+            if (args[k] == NULL || jobs <= 0 || args[k][0] == '-') {
+                printf(ROJO "parmap: Argumento inválido\n" RESET);
+                continue; // Argumento inválido, volver al bucle principal
             }
+            int failed = parmap(&args[k], jobs, ordered, path, &redirs);
+            if (failed == -1) {
+                printf(ROJO "parmap: no se pudo leer %s\n" RESET, path ? path : "la entrada");
+            }
+            vars_set_status(failed != 0);
+            continue; // Volver al bucle principal
         }
 
         // Comando interno: poner en primer plano un trabajo (fg)
@@ -312,10 +463,9 @@ int main(void)
             }
 
             // Cambiamos el estado del trabajo a FOREGROUND
-            fg_job->state = FOREGROUND;
+            set_job_state(job_list, fg_job, FOREGROUND);
             respawnable = 0;
-            // Ya no necesitamos acceso exclusivo a la lista
-            unblock_SIGCHLD();
+            // SIGCHLD sigue bloqueada hasta que wait_foreground lo espere
 
             // Cedemos el terminal al grupo de procesos del trabajo
             set_terminal(fg_job->pgid);
@@ -327,14 +477,15 @@ int main(void)
             enum status status_res;
 
             // Esperamos al proceso en primer plano (puede finalizar o suspenderse)
-            pid_t pid_wait = waitpid(fg_job->pgid, &status, WUNTRACED);
+            pid_t pid_wait = wait_foreground(fg_job->pgid, &status);
+            unblock_SIGCHLD();
             // Analizamos el estado en que terminó o cambió el proceso
             status_res = analyze_status(status, &info);
 
             // Si el proceso vuelve a suspenderse, lo marcamos como STOPPED
             if (status_res == SUSPENDED) {
                 block_SIGCHLD();
-                fg_job->state = STOPPED;
+                set_job_state(job_list, fg_job, STOPPED);
                 unblock_SIGCHLD();
                 printf(VERDE "Proceso %d suspendido de nuevo.\n" RESET, fg_job->pgid);
             } else if (status_res == EXITED || status_res == SIGNALED) {
@@ -343,6 +494,7 @@ int main(void)
                 printf(VERDE "Foreground pid: %d, Command: %s, Status: %s, Info: %d\n" RESET, 
                     pid_wait, fg_job->command, status_strings[status_res], info);
                 delete_job(job_list, fg_job);
+                dag_job_finished(job_list, pid_wait, status_res == EXITED && info == 0);
                 unblock_SIGCHLD();
             }
 
@@ -384,7 +536,7 @@ int main(void)
             }
 
             // Cambiamos el estado a BACKGROUND
-            bg_job->state = BACKGROUND;
+            set_job_state(job_list, bg_job, BACKGROUND);
             respawnable = 0;
             // Ya no necesitamos acceso exclusivo a la lista
             unblock_SIGCHLD();
@@ -398,6 +550,114 @@ int main(void)
             continue; // Volver al bucle principal
         }
 
+        // Comando interno: enviar señales a trabajos (kill, stop, cont)
+        // kill [-SEÑAL | -s SEÑAL] spec...   stop spec...   cont spec...
+        // spec: %n, %cmd, %T<equipo>, pid o -a estado (todos los de ese estado)
+        // Un pid que no es un trabajo recibe la señal con kill(2); las formas de
+        // kill que no son de trabajos (kill -l, kill -- -pgid...) ejecutan /bin/kill
+        if (strcmp(args[0], "kill") == 0 || strcmp(args[0], "stop") == 0 || strcmp(args[0], "cont") == 0) {
+            int sig = (args[0][0] == 'k') ? SIGTERM : (args[0][0] == 's') ? SIGSTOP : SIGCONT;
+            int k = 1, err = 0, external = 0, sent = 0;
+            job_set set;
+
+            if (args[0][0] == 'k' && args[k] != NULL && args[k][0] == '-' && strcmp(args[k], "-a") != 0) {
+                const char *name = (strcmp(args[k], "-s") == 0) ? args[++k] : args[k] + 1;
+                sig = (name != NULL) ? jobspec_parse_signal(name) : -1;
+                if (name != NULL) k++;
+            }
+            for (int j = k; args[j] != NULL && !external; j++) { // ¿todo son specs que entiende el builtin?
+                if (strcmp(args[j], "-a") == 0 && args[j + 1] != NULL && jobspec_is_state(args[j + 1])) j++;
+                else if (args[j][0] == '-') external = 1;
+            }
+            if (args[0][0] == 'k' && (sig == -1 || args[k] == NULL || external)) {
+                // no es una orden de trabajos: se ejecuta /bin/kill como un comando más
+            } else if (sig == -1 || args[k] == NULL || external) {
+                printf(ROJO "%s: Argumento inválido\n" RESET, args[0]);
+                continue; // Argumento inválido, volver al bucle principal
+            } else {
+                // Selección y envío con SIGCHLD bloqueada: la lista no cambia entre medias
+                block_SIGCHLD();
+                jobset_init(&set);
+                for (; args[k] != NULL && !err; k++) {
+                    int found, by_state = (strcmp(args[k], "-a") == 0);
+                    if (by_state) {
+                        found = jobspec_add_state(job_list, args[++k], &set);
+                    } else {
+                        found = jobspec_add(job_list, args[k], &set);
+                    }
+                    if (found == -1) {
+                        printf(ROJO "%s: %s: Argumento inválido\n" RESET, args[0], args[k]);
+                        err = 1;
+                    } else if (found == 0 && !by_state && args[k][0] != '%') { // pid que no es un trabajo
+                        if (kill((pid_t) atol(args[k]), sig) == -1) {
+                            printf(ROJO "%s: %s: %s\n" RESET, args[0], args[k], strerror(errno));
+                        } else {
+                            sent++;
+                        }
+                    } else if (found == 0) {
+                        printf(ROJO "%s: %s: no existe el trabajo\n" RESET, args[0], args[k]);
+                    }
+                }
+                if (!err && set.n + sent > 0) {
+                    sent += jobset_signal(job_list, &set, sig);
+                    printf(VERDE "%s: señal %d enviada a %d trabajos\n" RESET, args[0], sig, sent);
+                }
+                jobset_free(&set);
+                unblock_SIGCHLD();
+                continue; // Volver al bucle principal
+            }
+        }
+
+        // Comando interno: lanzador precalentado (zygote)
+        // zygote on|off  activa o desactiva el lanzador; zygote bench N [comando] compara latencias
+        if (strcmp(args[0], "zygote") == 0) {
+            if (args[1] == NULL) {
+                printf(VERDE "zygote: %s" RESET "\n", zygote_running() ? "activo" : "inactivo");
+            } else if (strcmp(args[1], "on") == 0) {
+                if (zygote_start() == 0) printf(VERDE "zygote activo (PID: %d)\n" RESET, zygote_pid());
+            } else if (strcmp(args[1], "off") == 0) {
+                zygote_stop();
+            } else if (strcmp(args[1], "bench") == 0 && args[2] != NULL && atoi(args[2]) > 0) {
+                char *bench_true[] = { "true", NULL };
+                zygote_bench(atoi(args[2]), args[3] ? &args[3] : bench_true);
+            } else {
+                printf(ROJO "zygote: Argumento inválido\n" RESET);
+            }
+            continue;
+        }
+
+        // Comando interno: comparar el tokenizador con el bucle original (parsebench)
+        // parsebench fichero [repeticiones]
+        if (strcmp(args[0], "parsebench") == 0) {
+            if (args[1] == NULL || (args[2] != NULL && atoi(args[2]) <= 0)) {
+                printf(ROJO "parsebench: Argumento inválido\n" RESET);
+            } else {
+                parse_bench(args[1], args[2] ? atoi(args[2]) : 1);
+            }
+            continue;
+        }
+
+        // Comando interno: cargar un grafo de dependencias desde un fichero (dag)
+        // dag [-j max_concurrentes] fichero; sin fichero lista los nodos pendientes
+        if (strcmp(args[0], "dag") == 0) {
+            int k = 1, max = 0;
+            if (args[k] && strcmp(args[k], "-j") == 0) {
+                if (args[k + 1] == NULL || (max = atoi(args[k + 1])) <= 0) {
+                    printf(ROJO "dag: Argumento inválido\n" RESET);
+                    continue;
+                }
+                k += 2;
+            }
+            block_SIGCHLD();
+            if (args[k] == NULL) {
+                dag_print();
+            } else {
+                dag_load(job_list, args[k], max);
+            }
+            unblock_SIGCHLD();
+            continue;
+        }
+
         // Comando interno: limitacion de tiempo de vida
         if (strcmp(args[0], "alarm-thread") == 0) {
 			if (!args[1]) { // Si no se especifica un tiempo, informamos y continuamos
@@ -422,8 +682,9 @@ int main(void)
             }
         }
 
-        // Postergar la ejecución del comando en background
-        if (strcmp(args[0], "delay-thread") == 0) {
+        // Postergar la ejecución del comando en background (delay-thread N comando)
+        // o lanzarlo periódicamente (every N comando). El proceso no se crea hasta que vence
+        if (strcmp(args[0], "delay-thread") == 0 || strcmp(args[0], "every") == 0) {
             if (!args[1]) { // Si no se especifica un tiempo, informamos y continuamos
 				printf(ROJO "Número de segundos a esperar no especificado\n" RESET);
 				continue;
@@ -434,7 +695,12 @@ int main(void)
 
 			if ((atoi(args[1]) > 0) || (strcmp(args[1], "0") == 0 && atoi(args[1]) == 0)) {
                 delay_seconds = atoi(args[1]); // Convertimos el argumento a entero
-                delay = 1; // Indicamos que se ha creado un hilo
+                period = (strcmp(args[0], "every") == 0) ? delay_seconds : 0; // every repite cada N segundos
+                if (period == 0 && strcmp(args[0], "every") == 0) {
+                    printf(ROJO "El periodo de every debe ser mayor que 0\n" RESET);
+                    continue;
+                }
+                delay = 1; // Indicamos que el lanzamiento queda programado
                 background = 1; // Indicamos que el comando se ejecutará en segundo plano
             } else {
                 printf(ROJO "Número de segundos a esperar no válido\n" RESET);
@@ -447,6 +713,129 @@ int main(void)
             }
         }
 
+        // Comando interno: cambiar nice, sched e ioprio de un trabajo en marcha (renice)
+        // renice [-n nice] [-p other|batch|idle] [-io clase[:nivel]] [n | %spec | pid]
+        // Lo que no es de trabajos (renice -n 5 -p PID, -g, -u...) ejecuta /usr/bin/renice
+        if (strcmp(args[0], "renice") == 0) {
+            int k = 1, res = 0;
+            job_set set;
+            while (args[k] && (res = parse_launch_opt(args, &k, &lopts)) == 1);
+            block_SIGCHLD();
+            jobset_init(&set);
+            if (res != -1 && k > 1 && (args[k] == NULL || args[k + 1] == NULL)) {
+                const char *spec = (args[k] != NULL) ? args[k] : "%1"; // Por defecto el primero de la lista
+                char pos[32];
+                if (spec[0] >= '0' && spec[0] <= '9') { // Número: posición en la lista o pid de un trabajo
+                    snprintf(pos, sizeof(pos), "%%%s", spec);
+                    if (jobspec_add(job_list, pos, &set) <= 0) jobspec_add(job_list, spec, &set);
+                } else if (spec[0] == '%') {
+                    jobspec_add(job_list, spec, &set);
+                }
+            }
+            if (set.n > 0) {
+                for (int j = 0; j < set.n; j++) {
+                    if (renice_group(set.items[j]->pgid, &lopts) == 0) {
+                        merge_launch_opts(&set.items[j]->opts, &lopts); // Se conservan al relanzar un respawnable
+                        printf(VERDE "Trabajo con PID %d replanificado\n" RESET, set.items[j]->pgid);
+                    }
+                }
+                jobset_free(&set);
+                unblock_SIGCHLD();
+                continue;
+            }
+            jobset_free(&set);
+            unblock_SIGCHLD();
+            init_launch_opts(&lopts); // Las opciones eran para el trabajo, no para /usr/bin/renice
+        }
+
+        // Comando interno: vigilar un respawnable y relanzarlo si se cuelga (health)
+        // health [-i seg] [-n fallos] [-p "orden"] [-hb fd] [-cpu] -c comando +
+        if (strcmp(args[0], "health") == 0) {
+            int k = 1, res = 0;
+            while (args[k] && (res = parse_health_opt(args, &k, &hopts)) == 1);
+            if (res == -1 || args[k] == NULL || strcmp(args[k], "-c") != 0 || k == 1) {
+                printf(ROJO "health: Argumento inválido\n" RESET);
+                continue;
+            }
+            if (respawnable == 0) {
+                printf(ROJO "health: solo se aplica a trabajos respawnable (+)\n" RESET);
+                continue;
+            }
+            for (int j = k + 1; args[j - (k + 1)]; j++) { // Eliminamos las opciones de health y el -c
+                args[j - (k + 1)] = args[j];
+            }
+            if (args[0] == NULL) {
+                printf(ROJO "No se ha incluido ningún comando\n" RESET);
+                continue;
+            }
+        }
+
+        // Comando interno: lanzar el comando con límites de recursos (ulimit)
+        // ulimit [-P perfil] [cpu=seg] [as=tam] [nofile=n] [nproc=n] [core=tam] -c comando
+        // ulimit -d perfil recurso=valor...  define un perfil; ulimit sin argumentos los lista
+        if (strcmp(args[0], "ulimit") == 0) {
+            int k = 1, res = 0;
+            if (args[1] == NULL) {
+                limit_profiles_print();
+                continue;
+            }
+            if (strcmp(args[1], "-d") == 0) { // Definir un perfil con nombre
+                launch_opts prof;
+                init_launch_opts(&prof);
+                for (k = 3; args[2] && args[k] && (res = parse_limit_opt(args[k], &prof)) == 1; k++);
+                if (args[2] == NULL || k == 3 || args[k] != NULL || limit_profile_define(args[2], &prof) == -1) {
+                    printf(ROJO "ulimit: Argumento inválido\n" RESET);
+                } else {
+                    printf(VERDE "Perfil de límites %s definido\n" RESET, args[2]);
+                }
+                continue;
+            }
+            while (args[k] && res != -1) { // Perfiles y límites sueltos, en orden (el último gana)
+                if (strcmp(args[k], "-P") == 0) {
+                    if (args[k + 1] == NULL || limit_profile_apply(args[k + 1], &lopts) == -1) {
+                        printf(ROJO "ulimit: no existe el perfil %s\n" RESET, args[k + 1] ? args[k + 1] : "");
+                        res = -2;
+                        break;
+                    }
+                    k += 2;
+                } else if ((res = parse_limit_opt(args[k], &lopts)) == 1) {
+                    k++;
+                } else {
+                    break;
+                }
+            }
+            if (res == -2) continue;
+            if (res == -1 || args[k] == NULL || strcmp(args[k], "-c") != 0 || k == 1) {
+                printf(ROJO "ulimit: Argumento inválido\n" RESET);
+                continue;
+            }
+            for (int j = k + 1; args[j - (k + 1)]; j++) { // Eliminamos los límites y el -c
+                args[j - (k + 1)] = args[j];
+            }
+            if (args[0] == NULL) {
+                printf(ROJO "No se ha incluido ningún comando\n" RESET);
+                continue;
+            }
+        }
+
+        // Comando interno: lanzar el comando con otra planificación (sched)
+        // sched [-n nice] [-p other|batch|idle] [-io clase[:nivel]] -c comando
+        if (strcmp(args[0], "sched") == 0) {
+            int k = 1, res = 0;
+            while (args[k] && (res = parse_launch_opt(args, &k, &lopts)) == 1);
+            if (res == -1 || args[k] == NULL || strcmp(args[k], "-c") != 0 || k == 1) {
+                printf(ROJO "sched: Argumento inválido\n" RESET);
+                continue;
+            }
+            for (int j = k + 1; args[j - (k + 1)]; j++) { // Eliminamos las opciones de sched y el -c
+                args[j - (k + 1)] = args[j];
+            }
+            if (args[0] == NULL) {
+                printf(ROJO "No se ha incluido ningún comando\n" RESET);
+                continue;
+            }
+        }
+
         // Comando interno: enmascarar señales en el hijo
         if (strcmp(args[0], "mask") == 0) {
             if (args[1] == NULL) { // No se han incluido señales a enmascarar
@@ -461,13 +850,12 @@ int main(void)
 			}
 			
             // Comprobamos si se ha incluido el -c
-			int hay_c = 0;
+			int hay_c = 0, tam;
 			for (tam = 0; args[tam]; tam++) {
 				if (strcmp(args[tam],"-c") == 0) {
 					hay_c = 1;
 					break;
 				} 
-				mask_args[tam] = args[tam]; // Array solo con los argumentos de mask
 			}
 			
 			// No se ha incluido el -c
@@ -479,7 +867,7 @@ int main(void)
 			// Comprobamos que los argumentos sean válidos
 			int valido = 1;
 			for (int j = 1; j < tam; j++) { // Empieza j=1 porque j=0 es "mask"
-				if (atoi(mask_args[j]) <= 0) {
+				if (atoi(args[j]) <= 0 || sigaddset(&lopts.mask, atoi(args[j])) == -1) {
 					valido = 0;
 					break;
 				}
@@ -497,34 +885,118 @@ int main(void)
                 printf(ROJO "No se ha incluido ningún comando\n" RESET);
                 continue;
             }
-			mask = 1;
 		}
+
+        // Comando interno: lanzar un comando cuando termine otro trabajo (after)
+        // after [-ok] n comando: con -ok solo se lanza si el trabajo n termina con éxito
+        // Va después de ulimit, sched y mask para que el comando se lance con ellos
+        if (strcmp(args[0], "after") == 0) {
+            int k = 1, need_ok = 0;
+            if (args[k] && strcmp(args[k], "-ok") == 0) {
+                need_ok = 1;
+                k++;
+            }
+            if (args[k] == NULL || atoi(args[k]) <= 0 || args[k + 1] == NULL) {
+                printf(ROJO "after: Argumento inválido\n" RESET);
+                continue;
+            }
+            if (delay || thread || bgt) { // El lanzamiento lo decide el trabajo del que depende
+                printf(ROJO "after: no se puede combinar con delay-thread, every, alarm-thread ni bgteam\n" RESET);
+                delay = thread = bgt = 0;
+                continue;
+            }
+            block_SIGCHLD();
+            job *dep_job = get_item_bypos(job_list, atoi(args[k]));
+            if (dep_job == NULL) {
+                printf(ROJO "after: no existe un trabajo en esa posición\n" RESET);
+            } else {
+                dag_after(job_list, dep_job, need_ok, &args[k + 1], &redirs, &lopts);
+            }
+            unblock_SIGCHLD();
+            continue;
+        }
+
+        // Comando interno: reutilizar el resultado de un comando determinista (memo)
+        // memo [-e VAR] [-d fichero] [-H] -c comando   memo [-s tamaño | -clear]
+        // Va después de ulimit, sched y mask para que el comando se lance con ellos
+        if (strcmp(args[0], "memo") == 0) {
+            int k = 1, res = 0;
+            memo_opts mopts;
+            memo_result mres;
+            if (args[1] == NULL) {
+                memo_stats();
+                continue;
+            }
+            if (strcmp(args[1], "-clear") == 0 && args[2] == NULL) {
+                printf(VERDE "memo: %d entradas eliminadas\n" RESET, memo_clear());
+                continue;
+            }
+            if (strcmp(args[1], "-s") == 0) {
+                if (args[2] == NULL || args[3] != NULL || memo_set_size(args[2]) == -1) {
+                    printf(ROJO "memo: tamaño inválido\n" RESET);
+                }
+                continue;
+            }
+            init_memo_opts(&mopts);
+            while (args[k] && (res = parse_memo_opt(args, &k, &mopts)) == 1);
+            if (res == -1 || args[k] == NULL || strcmp(args[k], "-c") != 0 || args[k + 1] == NULL) {
+                printf(ROJO "memo: Argumento inválido\n" RESET);
+                continue;
+            }
+            if (background || respawnable || delay || thread || bgt) { // Solo en primer plano
+                printf(ROJO "memo: solo se aplica a comandos en primer plano\n" RESET);
+                delay = thread = bgt = 0;
+                continue;
+            }
+            info = memo_run(&args[k + 1], &mopts, &lopts, &redirs, &mres);
+            vars_set_status(info);
+            if (mres.stopped) { /* Suspendido (ctrl+z): lo añadimos a jobs sin guardarlo */
+                njob = new_job(mres.pid, args[k + 1], STOPPED);
+                njob->opts = lopts;
+                block_SIGCHLD();
+                add_job(job_list, njob);
+                unblock_SIGCHLD();
+            }
+            if (etime == 1) {
+                print_etime(&start_time);
+                etime = 0;
+            }
+            if (mres.hit) { // Sin proceso: solo el resultado reproducido
+                printf(VERDE "memo: hit, output replayed (original run: %.3f s)\n" RESET, mres.run_ns / 1e9);
+                continue;
+            }
+            printf(VERDE "memo: miss, %s (run: %.3f s)\n" RESET, mres.stored ? "stored" : "not stored", mres.run_ns / 1e9);
+            if (mres.pid > 0) {
+                printf(VERDE "Foreground pid: %d, Command: %s, Status: %s, Info: %d\n" RESET, mres.pid, args[k + 1],
+                    status_strings[mres.stopped ? SUSPENDED : info < 128 ? EXITED : SIGNALED], info < 128 ? info : info - 128);
+            }
+            continue;
+        }
         
 		/* =========================    COMANDOS INTERNOS    ========================= */
 
 		/* =========================    BGTEAM    ========================= */
 
+        if (bgt > 0) { // Todos los miembros comparten un id de equipo (%T<id> en kill/stop/cont)
+            block_SIGCHLD();
+            team = new_team(job_list);
+            unblock_SIGCHLD();
+            printf(VERDE "Equipo [T%d]: %d trabajos -> Command: %s\n" RESET, team, bgt, args[0]);
+        }
+
         for (int i = 0; i < bgt; i++) {
-            bg_fork = fork();
-            switch (bg_fork) {
-            case -1: // Error al crear el proceso
+            block_SIGCHLD(); /* Bloqueamos hasta añadir el trabajo a la lista para evitar condiciones de carrera */
+            bg_fork = spawn_job(args, &lopts, NULL); /* nice, sched e ioprio indicados en bgteam */
+            if (bg_fork == -1) { // Error al crear el proceso
                 perror(ROJO "Error: fork() failed\n" RESET);
                 exit(-1);
-
-            case 0: // Proceso hijo
-                restore_terminal_signals(); /* Restaurar señales por defecto */
-                new_process_group(bg_fork); /* Crear un nuevo grupo de procesos */
-                execvp(args[0], args); /* Intentar ejecutar el comando */
-                exit(1); // Si falla, salimos con error
-
-            default: /* Proceso padre */
-                block_SIGCHLD();
-                njob = new_job(bg_fork, args[0], BACKGROUND);
-                add_job(job_list, njob); /* Bloqueamos y desbloqueamos la lista para evitar condiciones de carrera */
-                printf(VERDE "Background process running -> PID: %d, Command: %s\n" RESET, bg_fork, args[0]);
-                unblock_SIGCHLD();
-                break;
             }
+            njob = new_job(bg_fork, args[0], BACKGROUND);
+            njob->opts = lopts;
+            njob->team = team;
+            add_job(job_list, njob);
+            printf(VERDE "Background process running -> PID: %d, Command: %s\n" RESET, bg_fork, args[0]);
+            unblock_SIGCHLD();
         }
 
         if (bgt > 0) { // Si se ha introducido bgteam, reiniciamos la variable
@@ -534,81 +1006,45 @@ int main(void)
 
 		/* =========================    BGTEAM    ========================= */
 
-        // Crear un nuevo proceso con fork
-        pid_fork = fork();
+        // delay-thread / every: solo se guarda la entrada, el fork se hace cuando venza
+        if (delay == 1) {
+            int id = deferred_add(delay_seconds, period, args, &redirs, &lopts);
+            printf(VERDE "Lanzamiento programado [D%d] en %d segundos -> Command: %s\n" RESET, id, delay_seconds, args[0]);
+            delay = 0;
+            thread = 0; // alarm-thread no aplica a lanzamientos diferidos
+            continue;
+        }
+
+        // Utilidades triviales en primer plano (true, false, echo, pwd): se ejecutan
+        // dentro del shell, sin crear proceso
+        if (background == 0 && thread == 0 && launch_opts_empty(&lopts) && is_fastcmd(args, &redirs)) {
+            info = run_fastcmd(args, &redirs);
+            vars_set_status(info);
+            if (etime == 1) {
+                print_etime(&start_time);
+                etime = 0;
+            }
+            printf(VERDE "Foreground pid: %d, Command: %s, Status: %s, Info: %d\n" RESET,
+                pid_shell, args[0], status_strings[EXITED], info);
+            continue;
+        }
+
+        // Crear un nuevo proceso (con fork o con el lanzador si está activo).
+        // SIGCHLD queda bloqueada hasta esperarlo (wait_foreground) o añadirlo
+        // a la lista para que sigchld_handler no lo trate como un trabajo
+        block_SIGCHLD();
+        if (hopts.interval > 0 && (respawnable == 0 || health_prepare(&hopts, &redirs) == -1)) {
+            printf(ROJO "health: no se puede vigilar este trabajo\n" RESET);
+            unblock_SIGCHLD();
+            continue;
+        }
+        pid_fork = spawn_job(args, &lopts, &redirs);
 
         switch (pid_fork) {
             case -1: // Error al crear el proceso
                 perror(ROJO "Error: fork() failed\n" RESET);
                 exit(-1);
 
-            case 0: /* Proceso hijo */
-                restore_terminal_signals(); /* Restaurar señales por defecto */
-                new_process_group(pid_fork); /* Crear un nuevo grupo de procesos */
-                if (mask == 1) { // Enmascarar señales si se ha introducido mask
-                    for (int j = 1; j < tam; j++) {
-                        mask_signal(atoi(mask_args[j]), 0);
-                    }
-                }
-
-                // Redirecciones de entrada y salida
-                        
-                if (file_in != NULL) { // Redirección de entrada si file_in no es NULL
-                    int fd_in = open(file_in, O_RDONLY);
-                    if (fd_in < 0) {
-                        perror(ROJO "Error abriendo fichero de entrada" RESET);
-                        exit(1);
-                    }
-                    if (dup2(fd_in, STDIN_FILENO) < 0) {
-                        perror(ROJO "Error en dup2 para entrada" RESET);
-                        close(fd_in);
-                        exit(1);
-                    }
-                    close(fd_in); // ya no necesitamos el descriptor original
-                }
-
-                if (file_out != NULL) { // Redirección de salida si file_out no es NULL
-                    // Abrir en escritura, crear si no existe, truncar si existe
-                    int fd_out = open(file_out, O_WRONLY | O_CREAT | O_TRUNC, 0666);
-                    if (fd_out < 0) {
-                        perror(ROJO "Error abriendo fichero de salida" RESET);
-                        exit(1);
-                    }
-                    if (dup2(fd_out, STDOUT_FILENO) < 0) {
-                        perror(ROJO "Error en dup2 para salida" RESET);
-                        close(fd_out);
-                        exit(1);
-                    }
-                    close(fd_out); // ya no necesitamos el descriptor original
-                }
-
-                // Delay si se ha introducido delay-thread
-                if (delay == 1) {
-                    ThreadArgs *targs = (ThreadArgs *)malloc(sizeof(ThreadArgs)); // Creamos la estructura con los argumentos
-                    targs->tiempo = delay_seconds; // Asignamos el tiempo
-                    pthread_create(&tid, &attr, delay_thread, targs); // Creamos el hilo
-                    pthread_join(tid, NULL); // Esperamos a que el hilo termine
-                    printf(VERDE "Background process running -> PID: %d, Command: %s\n" RESET, getpid(), args[0]);
-                }
-
-                execvp(args[0], args); /* Intentar ejecutar el comando */
-
-                // Manejo de errores si execvp falla
-                switch (errno) {
-                    case ENOENT: /* Archivo no encontrado */
-                        fprintf(stderr, ROJO "error: command not found: %s\n" RESET, args[0]);
-                        exit(127);
-                    case EACCES: /* Permisos insuficientes */
-                        fprintf(stderr, ROJO "error: permission denied: %s\n" RESET, args[0]);
-                        exit(126);
-                    case ENOEXEC: /* No es un ejecutable válido */
-                        fprintf(stderr, ROJO "error: not an executable: %s\n" RESET, args[0]);
-                        exit(126);
-                    default: /* Otros errores */
-                        fprintf(stderr, ROJO "error: execvp failed (%s): %s\n" RESET, strerror(errno), args[0]);
-                        exit(EXIT_FAILURE);
-                }
-
             default: /* Proceso padre */
 
                 if (thread == 1) { // Si se ha creado un hilo para el temporizador
@@ -621,34 +1057,23 @@ int main(void)
                     thread = 0; // Reiniciamos la variable
                 }
 
-                if (delay == 1) {
-                    tid++; // Incrementamos el identificador del hilo
-                    delay = 0; // Reiniciamos la variable
-                }
-
                 if (background == 0) { /* Comando en primer plano */
                     set_terminal(pid_fork); /* Asignar terminal al hijo */
-                    pid_wait = waitpid(pid_fork, &status, WUNTRACED);
+                    pid_wait = wait_foreground(pid_fork, &status);
+                    unblock_SIGCHLD();
                     set_terminal(pid_shell); /* Devolver terminal al shell */
                     if (etime == 1) {
-                        if (clock_gettime(CLOCK_MONOTONIC, &end_time) == -1) { // Medir el tiempo de ejecución
-                            perror(ROJO "Error: clock_gettime failed\n" RESET);
-                        }
-                        long int segundos = end_time.tv_sec - start_time.tv_sec; // Calcular el tiempo de ejecución
-                        long int nanosegundos = end_time.tv_nsec - start_time.tv_nsec;
-                        if (nanosegundos < 0) { // Corregir si los nanosegundos son negativos
-                            segundos--;
-                            nanosegundos += 1000000000;
-                        }
-                        printf(MARRON "Tiempo de ejecución: %ld.%09ld segundos\n" RESET, segundos, nanosegundos);
+                        print_etime(&start_time);
                         etime = 0; // Reiniciamos la variable
                     }
                     status_res = analyze_status(status, &info);
+                    vars_set_status(status_res == EXITED ? info : 128 + info);
 
 					// Comprobamos el estado del hijo
                     switch (status_res) {
                         case SUSPENDED: /* Si ha sido suspendido lo añadimos a jobs */
                             njob = new_job(pid_fork, args[0], STOPPED);
+                            njob->opts = lopts;
 
 							block_SIGCHLD();
                             add_job(job_list, njob); /* Bloqueamos y desbloqueamos la lista para evitar condiciones de carrera */
@@ -657,6 +1082,9 @@ int main(void)
 						default: /* Si no ha sido suspendido ha acabado */
                             printf(VERDE "Foreground pid: %d, Command: %s, Status: %s, Info: %d\n" RESET, 
                                 pid_wait, args[0], status_strings[status_res], info);
+                            if (status_res == SIGNALED && info == SIGXCPU) { // Agotó el límite de CPU de ulimit
+                                printf(MARRON "Process %d (%s) hit its CPU time limit\n" RESET, pid_wait, args[0]);
+                            }
                             break;
                     }
 
@@ -664,14 +1092,15 @@ int main(void)
                     block_SIGCHLD();
 					if (respawnable == 1) {
                         njob = new_job(pid_fork, args[0], RESPAWNABLE);
+                        njob->opts = lopts;
                         add_resp_job(job_list, njob, args);
+                        if (hopts.interval > 0) health_attach(njob, &hopts); // Conserva la tubería para los relanzamientos
                         printf(VERDE "Respawnable process running -> PID: %d, Command: %s\n" RESET, pid_fork, args[0]);
                     } else {
                         njob = new_job(pid_fork, args[0], BACKGROUND);
+                        njob->opts = lopts;
                         add_job(job_list, njob); /* Bloqueamos y desbloqueamos la lista para evitar condiciones de carrera */
-                        if (delay != 1) {
                         printf(VERDE "Background process running -> PID: %d, Command: %s\n" RESET, pid_fork, args[0]);
-                        }
                     }
                     unblock_SIGCHLD();
                 }
@@ -0,0 +1,134 @@
+/*--------------------------------------------------------
+UNIX Shell Project
+cmdsubst module: ejecuta la orden de un $(...) y devuelve su salida
+
+La salida se captura en un memfd: los comandos externos se lanzan con
+spawn_job y la salida redirigida a él (por /proc, así también vale con el
+lanzador zygote); las utilidades triviales (fastcmd) se ejecutan dentro
+del shell escribiendo en el mismo memfd, y $(< fichero) no ejecuta nada.
+El resultado se proyecta con mmap y el tokenizador lo copia directamente
+a los argumentos: en cada nivel de anidamiento los datos se copian una
+sola vez, sin buffers intermedios.
+
+Sistemas Operativos
+Grados I. Informatica, Computadores & Software
+Dept. Arquitectura de Computadores - UMA
+Iván Ballesteros Fernández - 24-25 - 2ºGCIA
+--------------------------------------------------------*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include "job_control.h"
+#include "parse_redir.h"
+#include "cmdsubst.h"
+#include "fastcmd.h"
+#include "tokenizer.h"
+#include "vars.h"
+
+// -----------------------------------------------------------------------
+/* proyecta el contenido de fd en out quitando los '\n' finales */
+static void map_output(int fd, cmdsubst_out *out)
+{
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size == 0) return;
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) return;
+    out->map = map;
+    out->map_len = st.st_size;
+    out->data = map;
+    out->len = st.st_size;
+    while (out->len > 0 && out->data[out->len - 1] == '\n') out->len--;
+}
+
+/* lanza argv con la salida capturada y espera a que termine; el hijo
+   tiene el terminal mientras dura (ctrl+c lo interrumpe a él) */
+static int run_external(char **argv, const redir_list *redirs)
+{
+    sigset_t block, old;
+    int wstatus, info;
+    pid_t pid;
+
+    sigemptyset(&block);
+    sigaddset(&block, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &block, &old); // lo recoge wait_foreground, no sigchld_handler
+    pid = spawn_job(argv, NULL, redirs);
+    if (pid < 0) {
+        sigprocmask(SIG_SETMASK, &old, NULL);
+        perror("$(...): fork");
+        return 1;
+    }
+    set_terminal(pid);
+    while (wait_foreground(pid, &wstatus) == pid && WIFSTOPPED(wstatus)) {
+        killpg(pid, SIGKILL); // suspendido no puede terminar de escribir la salida
+    }
+    set_terminal(getpid());
+    sigprocmask(SIG_SETMASK, &old, NULL);
+    return (analyze_status(wstatus, &info) == EXITED) ? info : 128 + info;
+}
+
+// -----------------------------------------------------------------------
+/* ejecuta text[0..length) y deja su salida en out (vacía si no produce
+   nada). Debe llamarse con el tokenizador libre: tokenize_line guarda su
+   estado antes. devuelve 0 o el error del tokenizador */
+int cmdsubst_run(char *text, int length, cmdsubst_out *out)
+{
+    char **argv, path[64];
+    int background = 0, respawnable = 0, status = 0;
+    redir_list redirs;
+
+    memset(out, 0, sizeof(*out));
+    int n = tokenize_line(text, length, &argv, &background, &respawnable);
+    if (n < 0) return n;
+    if (n == 0) return 0;
+
+    if (n == 2 && strcmp(argv[0], "<") == 0) { // $(< fichero): se proyecta el fichero
+        int fd = open(argv[1], O_RDONLY);
+        if (fd < 0) {
+            fprintf(stderr, "$(...): %s: %s\n", argv[1], strerror(errno));
+            vars_set_status(1);
+            return 0;
+        }
+        map_output(fd, out);
+        close(fd);
+        vars_set_status(0);
+        return 0;
+    }
+
+    parse_redirections(argv, tokenize_literal(), &redirs);
+    if (argv[0] == NULL || redirs.n == MAX_REDIRS) {
+        fprintf(stderr, "$(...): syntax error in redirection\n");
+        return 0;
+    }
+
+    int fd = memfd_create("cmdsubst", MFD_CLOEXEC);
+    if (fd < 0) {
+        perror("$(...): memfd_create");
+        return 0;
+    }
+    // la captura va antes que las redirecciones propias de la orden
+    memmove(&redirs.ops[1], &redirs.ops[0], redirs.n * sizeof(redir_op));
+    snprintf(path, sizeof(path), "/proc/%d/fd/%d", getpid(), fd);
+    redirs.ops[0].type = REDIR_OUT;
+    redirs.ops[0].fd = STDOUT_FILENO;
+    redirs.ops[0].path = path;
+    redirs.n++;
+
+    if (is_fastcmd(argv, &redirs)) status = run_fastcmd(argv, &redirs);
+    else status = run_external(argv, &redirs);
+    vars_set_status(status);
+
+    map_output(fd, out);
+    close(fd); // la proyección sigue valiendo
+    return 0;
+}
+
+/* libera la salida de cmdsubst_run */
+void cmdsubst_release(cmdsubst_out *out)
+{
+    if (out->map != NULL) munmap(out->map, out->map_len);
+    memset(out, 0, sizeof(*out));
+}
@@ -0,0 +1,32 @@
+/*--------------------------------------------------------
+UNIX Shell Project
+function prototypes and type declarations for cmdsubst module:
+sustitución de órdenes $(...)
+
+Sistemas Operativos
+Grados I. Informatica, Computadores & Software
+Dept. Arquitectura de Computadores - UMA
+Iván Ballesteros Fernández - 24-25 - 2ºGCIA
+--------------------------------------------------------*/
+
+#ifndef _CMDSUBST_H
+#define _CMDSUBST_H
+
+#include <stddef.h>
+
+// ----------- SALIDA CAPTURADA -----------------------------------------
+typedef struct cmdsubst_out_
+{
+	const char * data; /* salida (proyectada con mmap), sin '\n' finales */
+	size_t len;
+	void * map;        /* proyección que hay que liberar, NULL si no hay */
+	size_t map_len;
+} cmdsubst_out;
+
+// -----------------------------------------------------------------------
+//      PUBLIC FUNCTIONS
+// -----------------------------------------------------------------------
+int cmdsubst_run(char *text, int length, cmdsubst_out *out);
+void cmdsubst_release(cmdsubst_out *out);
+
+#endif
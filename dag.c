@@ -0,0 +1,351 @@
+/*--------------------------------------------------------
+UNIX Shell Project
+dag module: planificador de trabajos con dependencias (after, dag)
+
+Los nodos listos se lanzan como trabajos en segundo plano de la lista de
+trabajos; cuando sigchld_handler informa de que uno termina se marcan sus
+sucesores y se lanzan los que queden listos sin pasar del límite de
+concurrencia. Todas las funciones se llaman con SIGCHLD bloqueada.
+
+Sistemas Operativos
+Grados I. Informatica, Computadores & Software
+Dept. Arquitectura de Computadores - UMA
+Iván Ballesteros Fernández - 24-25 - 2ºGCIA
+--------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dag.h"
+
+#define DAG_LINE 1024
+
+static const char *node_state_strings[] = { "Waiting", "Running", "Succeeded", "Failed", "Skipped" };
+
+static dag_node *nodes = NULL; // lista de nodos de todos los grafos pendientes
+static int running = 0;        // nodos lanzados que aún no han terminado
+static int next_graph = 1;
+
+// -----------------------------------------------------------------------
+static double elapsed(struct timespec *a, struct timespec *b)
+{
+    return (b->tv_sec - a->tv_sec) + (b->tv_nsec - a->tv_nsec) / 1e9;
+}
+
+// -----------------------------------------------------------------------
+static dag_node * new_node(const char *name, char **argv, int graph)
+{
+    dag_node *n = (dag_node *) calloc(1, sizeof(dag_node));
+    n->name = strdup(name);
+    n->graph = graph;
+    n->state = WAITING;
+    init_launch_opts(&n->opts); // redirs queda vacía (calloc)
+    if (argv) {
+        int argc = 0;
+        while (argv[argc]) argc++;
+        n->argv = (char **) malloc((argc + 1) * sizeof(char *));
+        for (int i = 0; i < argc; i++) n->argv[i] = strdup(argv[i]);
+        n->argv[argc] = NULL;
+    }
+    n->next = nodes;
+    nodes = n;
+    return n;
+}
+
+// -----------------------------------------------------------------------
+static void free_node(dag_node *n)
+{
+    if (n->argv) {
+        for (int i = 0; n->argv[i]; i++) free(n->argv[i]);
+        free(n->argv);
+    }
+    free_redirections(&n->redirs);
+    free(n->name);
+    free(n);
+}
+
+// -----------------------------------------------------------------------
+/* busca un nodo de un grafo por nombre o por pgid (name NULL) */
+static dag_node * find_node(int graph, const char *name, pid_t pgid)
+{
+    for (dag_node *n = nodes; n; n = n->next) {
+        if (name && n->graph == graph && strcmp(n->name, name) == 0) return n;
+        if (!name && n->pgid == pgid && n->state == RUNNING) return n;
+    }
+    return NULL;
+}
+
+// -----------------------------------------------------------------------
+/* 1 si se puede lanzar, 0 si debe esperar, -1 si hay que saltarlo */
+static int node_ready(dag_node *n)
+{
+    for (int i = 0; i < n->ndeps; i++) {
+        enum node_state s = n->deps[i]->state;
+        if (s == WAITING || s == RUNNING) return 0;
+        if (n->need_ok && s != SUCCEEDED) return -1;
+    }
+    return 1;
+}
+
+// -----------------------------------------------------------------------
+/* imprime la ruta crítica del grafo: partiendo del último nodo en
+   terminar, se sigue hacia atrás la dependencia que terminó más tarde,
+   que es la que retrasó el arranque de cada nodo */
+static void report_graph(int graph)
+{
+    dag_node *last = NULL;
+    struct timespec first = {0, 0};
+    int count = 0;
+    double work = 0;
+
+    for (dag_node *n = nodes; n; n = n->next) {
+        if (n->graph != graph || n->state == SKIPPED || !n->argv) continue;
+        if (!last || elapsed(&last->end, &n->end) > 0) last = n;
+        if (!count || elapsed(&n->start, &first) > 0) first = n->start;
+        work += elapsed(&n->start, &n->end);
+        count++;
+    }
+    if (!last) return;
+
+    dag_node *path[64];
+    int len = 0;
+    for (dag_node *n = last; n && len < 64; ) {
+        path[len++] = n;
+        dag_node *gate = NULL;
+        for (int i = 0; i < n->ndeps; i++) {
+            if (n->deps[i]->argv && (!gate || elapsed(&gate->end, &n->deps[i]->end) > 0))
+                gate = n->deps[i];
+        }
+        n = gate;
+    }
+
+    double wall = elapsed(&first, &last->end);
+    printf("Grafo %d terminado: %d nodos, %.3f s de reloj, %.3f s de trabajo\n", graph, count, wall, work);
+    printf("Ruta crítica:");
+    for (int i = len - 1; i >= 0; i--) {
+        printf(" %s (%.3f s)%s", path[i]->name, elapsed(&path[i]->start, &path[i]->end), i ? " ->" : "\n");
+    }
+}
+
+// -----------------------------------------------------------------------
+/* elimina los grafos cuyos nodos hayan terminado todos */
+static void collect_graphs(void)
+{
+    dag_node **p;
+    for (dag_node *n = nodes; n; n = n->next) {
+        int g = n->graph, done = 1;
+        if (g == 0) continue; // grafo ya recogido en esta pasada
+        for (dag_node *m = nodes; m; m = m->next) {
+            if (m->graph == g && (m->state == WAITING || m->state == RUNNING)) done = 0;
+        }
+        if (!done) continue;
+        if (g > 0) report_graph(g); // los grafos de `after` (negativos) no se resumen
+        for (dag_node *m = nodes; m; m = m->next) if (m->graph == g) m->graph = 0;
+    }
+    p = &nodes;
+    while (*p) {
+        if ((*p)->graph == 0) {
+            dag_node *aux = *p;
+            *p = aux->next;
+            free_node(aux);
+        } else {
+            p = &(*p)->next;
+        }
+    }
+}
+
+// -----------------------------------------------------------------------
+/* nodos del grafo g que están en marcha */
+static int graph_running(int g)
+{
+    int count = 0;
+    for (dag_node *n = nodes; n; n = n->next) count += (n->graph == g && n->state == RUNNING);
+    return count;
+}
+
+/* lanza los nodos que estén listos respetando el límite de cada grafo */
+static void schedule(job * list)
+{
+    int progress = 1;
+    while (progress) {
+        progress = 0;
+        for (dag_node *n = nodes; n; n = n->next) {
+            if (n->state != WAITING || !n->argv) continue;
+            if (n->max_running > 0 && graph_running(n->graph) >= n->max_running) continue;
+            int ready = node_ready(n);
+            if (ready == 0) continue;
+            clock_gettime(CLOCK_MONOTONIC, &n->start);
+            if (ready < 0) {
+                n->end = n->start;
+                n->state = SKIPPED;
+                printf("dag: %s saltado, una dependencia falló\n", n->name);
+                progress = 1; // puede desbloquear otros nodos que solo esperaban a que terminara
+                continue;
+            }
+            n->pgid = spawn_job(n->argv, &n->opts, &n->redirs);
+            if (n->pgid < 0) {
+                perror("dag: fork");
+                n->end = n->start;
+                n->state = FAILED;
+                progress = 1;
+                continue;
+            }
+            n->state = RUNNING;
+            running++;
+            job *njob = new_job(n->pgid, n->argv[0], BACKGROUND);
+            njob->opts = n->opts;
+            add_job(list, njob);
+            printf("dag: %s lanzado -> PID: %d\n", n->name, n->pgid);
+        }
+    }
+    fflush(stdout);
+}
+
+// -----------------------------------------------------------------------
+/* lanza argv (con sus redirecciones y opciones) cuando termine el
+   trabajo dep (con éxito si need_ok). devuelve 0 si se ha encolado */
+int dag_after(job * list, job * dep, int need_ok, char **argv,
+              const redir_list *redirs, const launch_opts *opts)
+{
+    int graph = -(next_graph++);
+    dag_node *ext = find_node(0, NULL, dep->pgid);
+    if (ext == NULL) { // el trabajo no lo lanzó el planificador: nodo externo
+        ext = new_node(dep->command, NULL, graph);
+        ext->pgid = dep->pgid;
+        ext->state = RUNNING;
+    }
+    dag_node *n = new_node(argv[0], argv, ext->graph);
+    n->need_ok = need_ok;
+    n->deps[n->ndeps++] = ext;
+    copy_redirections(&n->redirs, redirs);
+    n->opts = *opts;
+    printf("after: %s esperará a que termine el PID %d\n", argv[0], dep->pgid);
+    schedule(list);
+    return 0;
+}
+
+// -----------------------------------------------------------------------
+/* carga un fichero con una línea por nodo:
+       nombre [dependencia ...] : comando [argumentos ...]
+   las líneas vacías y las que empiezan por # se ignoran.
+   devuelve el número de nodos cargados o -1 si hay errores */
+int dag_load(job * list, const char *path, int max)
+{
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL) {
+        perror("dag");
+        return -1;
+    }
+    int graph = next_graph++, count = 0, lineno = 0, error = 0;
+    char line[DAG_LINE];
+    char *words[DAG_LINE / 2 + 1]; // como mucho una palabra cada dos caracteres, más el NULL
+
+    // primera pasada: crear los nodos. Las dependencias se guardan por
+    // nombre en una lista auxiliar porque pueden aparecer más abajo
+    typedef struct pending_ { dag_node *node; char *names[DAG_MAX_DEPS]; struct pending_ *next; } pending;
+    pending *todo = NULL;
+
+    while (!error && fgets(line, sizeof(line), fp)) {
+        int nw = 0, colon = -1;
+        lineno++;
+        for (char *tok = strtok(line, " \t\n"); tok; tok = strtok(NULL, " \t\n")) {
+            if (colon < 0 && strcmp(tok, ":") == 0) colon = nw;
+            else words[nw++] = tok;
+        }
+        if (nw == 0 || words[0][0] == '#') continue;
+        if (colon < 1 || colon >= nw || colon > DAG_MAX_DEPS + 1 || find_node(graph, words[0], 0)) {
+            fprintf(stderr, "dag: %s:%d: línea no válida\n", path, lineno);
+            error = 1;
+            break;
+        }
+        words[nw] = NULL;
+        pending *p = (pending *) malloc(sizeof(pending));
+        p->node = new_node(words[0], &words[colon], graph);
+        p->node->need_ok = 1;
+        p->node->ndeps = colon - 1;
+        for (int i = 1; i < colon; i++) p->names[i - 1] = strdup(words[i]);
+        p->next = todo;
+        todo = p;
+        count++;
+    }
+    fclose(fp);
+
+    // segunda pasada: resolver los nombres a nodos del grafo
+    while (todo) {
+        pending *p = todo;
+        for (int i = 0; i < p->node->ndeps; i++) {
+            p->node->deps[i] = find_node(graph, p->names[i], 0);
+            if (!error && p->node->deps[i] == NULL) {
+                fprintf(stderr, "dag: %s: dependencia desconocida: %s\n", p->node->name, p->names[i]);
+                error = 1;
+            }
+            free(p->names[i]);
+        }
+        todo = p->next;
+        free(p);
+    }
+
+    // un grafo con ciclos nunca terminaría: se detectan eliminando nodos sin dependencias pendientes
+    int resolved = 0, progress = 1;
+    for (dag_node *n = nodes; n; n = n->next) if (n->graph == graph) n->pgid = 0;
+    while (!error && progress) {
+        progress = 0;
+        for (dag_node *n = nodes; n; n = n->next) {
+            if (n->graph != graph || n->pgid) continue;
+            int ok = 1;
+            for (int i = 0; i < n->ndeps; i++) if (!n->deps[i]->pgid) ok = 0;
+            if (ok) { n->pgid = 1; resolved++; progress = 1; }
+        }
+    }
+    if (!error && resolved != count) {
+        fprintf(stderr, "dag: %s: el grafo tiene ciclos\n", path);
+        error = 1;
+    }
+
+    for (dag_node *n = nodes; n; n = n->next) {
+        if (n->graph != graph) continue;
+        n->pgid = 0;
+        n->max_running = (max > 0) ? max : 0; // el límite es de este grafo, no de los siguientes
+        if (error) n->graph = 0; // se descarta el grafo entero
+    }
+    if (error) {
+        collect_graphs();
+        return -1;
+    }
+
+    printf("dag: %d nodos cargados de %s (grafo %d)\n", count, path, graph);
+    schedule(list);
+    return count;
+}
+
+// -----------------------------------------------------------------------
+/* llamada por sigchld_handler (y fg) cuando termina el grupo pgid */
+void dag_job_finished(job * list, pid_t pgid, int success)
+{
+    dag_node *n = find_node(0, NULL, pgid);
+    if (n == NULL) return;
+    clock_gettime(CLOCK_MONOTONIC, &n->end);
+    n->state = success ? SUCCEEDED : FAILED;
+    if (n->argv) running--;
+    schedule(list);
+    collect_graphs();
+}
+
+// -----------------------------------------------------------------------
+/* lista los nodos pendientes */
+void dag_print(void)
+{
+    if (nodes == NULL) {
+        printf("No hay nodos pendientes\n");
+        return;
+    }
+    printf("Nodos pendientes (en marcha %d):\n", running);
+    for (dag_node *n = nodes; n; n = n->next) {
+        if (!n->argv) continue;
+        printf(" grafo %d: %s, state: %s", n->graph < 0 ? -n->graph : n->graph, n->name, node_state_strings[n->state]);
+        if (n->state == RUNNING) printf(", pid: %d", n->pgid);
+        if (n->max_running > 0) printf(", límite del grafo: %d", n->max_running);
+        for (int i = 0; i < n->ndeps; i++) printf("%s%s", i ? " " : ", deps: ", n->deps[i]->name);
+        printf("\n");
+    }
+}
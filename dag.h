@@ -0,0 +1,50 @@
+/*--------------------------------------------------------
+UNIX Shell Project
+function prototypes and type declarations for dag module:
+ejecución de comandos que dependen de que terminen otros trabajos
+
+Sistemas Operativos
+Grados I. Informatica, Computadores & Software
+Dept. Arquitectura de Computadores - UMA
+Iván Ballesteros Fernández - 24-25 - 2ºGCIA
+--------------------------------------------------------*/
+
+#ifndef _DAG_H
+#define _DAG_H
+
+#include <time.h>
+#include "job_control.h"
+
+#define DAG_MAX_DEPS 16 /* dependencias máximas por nodo */
+
+// ----------- ENUMERATIONS ---------------------------------------------
+enum node_state { WAITING, RUNNING, SUCCEEDED, FAILED, SKIPPED };
+
+// ----------- NODO DEL GRAFO DE DEPENDENCIAS ---------------------------
+typedef struct dag_node_
+{
+	char * name;  /* nombre del nodo (o comando para `after`) */
+	char ** argv; /* NULL si es un trabajo externo ya lanzado */
+	pid_t pgid;   /* grupo del proceso una vez lanzado */
+	int graph;    /* grafo al que pertenece */
+	int need_ok;  /* las dependencias deben terminar con éxito */
+	int max_running; /* límite de nodos en marcha de su grafo (0 = sin límite) */
+	redir_list redirs; /* redirecciones del comando (copia propia) */
+	launch_opts opts;  /* nice, sched, ulimit y mask con los que se lanza */
+	int ndeps;
+	struct dag_node_ * deps[DAG_MAX_DEPS];
+	enum node_state state;
+	struct timespec start, end;
+	struct dag_node_ *next;
+} dag_node;
+
+// -----------------------------------------------------------------------
+//      PUBLIC FUNCTIONS
+// -----------------------------------------------------------------------
+int dag_after(job * list, job * dep, int need_ok, char **argv,
+              const redir_list *redirs, const launch_opts *opts);
+int dag_load(job * list, const char *path, int max_running);
+void dag_job_finished(job * list, pid_t pgid, int success);
+void dag_print(void);
+
+#endif
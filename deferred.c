@@ -0,0 +1,327 @@
+/*--------------------------------------------------------
+UNIX Shell Project
+deferred module: lanzamientos diferidos y periódicos
+
+Cada lanzamiento programado es solo una entrada en un montículo ordenado
+por instante de lanzamiento; no se crea ningún proceso hasta que vence.
+Un único temporizador (ITIMER_REAL) se programa para la entrada más
+próxima. El manejador de SIGALRM solo escribe un byte en una tubería
+(nada de malloc ni stdio dentro de él); el bucle principal espera en ella
+a la vez que en la entrada y deferred_run lanza las que hayan vencido. Otros
+módulos (health) ponen también entradas periódicas que en lugar de lanzar
+un comando llaman a una función; esas no se listan en jobs.
+
+Sistemas Operativos
+Grados I. Informatica, Computadores & Software
+Dept. Arquitectura de Computadores - UMA
+Iván Ballesteros Fernández - 24-25 - 2ºGCIA
+--------------------------------------------------------*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include "deferred.h"
+
+static job *jobs = NULL;       // lista de trabajos donde se añaden los lanzados
+static deferred **heap = NULL; // montículo de mínimos por 'due'
+static int heap_len = 0, heap_cap = 0;
+static int next_id = 1;
+static int ncalls = 0;         // entradas que son llamadas (deferred_add_call)
+static int wake[2] = { -1, -1 }; // aviso del manejador de SIGALRM al bucle principal
+
+// -----------------------------------------------------------------------
+static int before(deferred *a, deferred *b)
+{
+    if (a->due.tv_sec != b->due.tv_sec) return a->due.tv_sec < b->due.tv_sec;
+    return a->due.tv_nsec < b->due.tv_nsec;
+}
+
+static int cmp_due(const void *a, const void *b)
+{
+    deferred *x = *(deferred **) a, *y = *(deferred **) b;
+    return before(x, y) ? -1 : before(y, x);
+}
+
+static int expired(deferred *d, struct timespec *now)
+{
+    return d->due.tv_sec < now->tv_sec ||
+           (d->due.tv_sec == now->tv_sec && d->due.tv_nsec <= now->tv_nsec);
+}
+
+static void heap_set(int pos, deferred *d)
+{
+    heap[pos] = d;
+    d->heap_pos = pos;
+}
+
+static void sift_up(int pos)
+{
+    deferred *d = heap[pos];
+    while (pos > 0 && before(d, heap[(pos - 1) / 2])) {
+        heap_set(pos, heap[(pos - 1) / 2]);
+        pos = (pos - 1) / 2;
+    }
+    heap_set(pos, d);
+}
+
+static void sift_down(int pos)
+{
+    deferred *d = heap[pos];
+    for (;;) {
+        int child = 2 * pos + 1;
+        if (child >= heap_len) break;
+        if (child + 1 < heap_len && before(heap[child + 1], heap[child])) child++;
+        if (!before(heap[child], d)) break;
+        heap_set(pos, heap[child]);
+        pos = child;
+    }
+    heap_set(pos, d);
+}
+
+static void heap_push(deferred *d)
+{
+    if (heap_len == heap_cap) {
+        heap_cap = heap_cap ? 2 * heap_cap : 64;
+        heap = (deferred **) realloc(heap, heap_cap * sizeof(deferred *));
+    }
+    heap_set(heap_len++, d);
+    sift_up(heap_len - 1);
+}
+
+static void heap_remove(int pos)
+{
+    deferred *last = heap[--heap_len];
+    if (pos == heap_len) return;
+    heap_set(pos, last);
+    sift_up(pos);
+    sift_down(last->heap_pos);
+}
+
+// -----------------------------------------------------------------------
+static void free_deferred(deferred *d)
+{
+    if (d->call != NULL) {
+        ncalls--;
+        free(d);
+        return;
+    }
+    for (int i = 0; d->argv[i]; i++) free(d->argv[i]);
+    free(d->argv);
+    free_redirections(&d->redirs);
+    free(d);
+}
+
+// -----------------------------------------------------------------------
+/* programa el temporizador para la entrada más próxima (o lo desactiva) */
+static void arm_timer(void)
+{
+    struct itimerval it = { {0, 0}, {0, 0} };
+    if (heap_len > 0) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        long sec = heap[0]->due.tv_sec - now.tv_sec;
+        long nsec = heap[0]->due.tv_nsec - now.tv_nsec;
+        if (nsec < 0) { sec--; nsec += 1000000000; }
+        if (sec < 0 || (sec == 0 && nsec < 1000)) { sec = 0; nsec = 1000; } // ya vencida: lo antes posible
+        it.it_value.tv_sec = sec;
+        it.it_value.tv_usec = nsec / 1000;
+    }
+    setitimer(ITIMER_REAL, &it, NULL);
+}
+
+// -----------------------------------------------------------------------
+static void launch(deferred *d)
+{
+    pid_t pid = spawn_job(d->argv, &d->opts, &d->redirs);
+    if (pid < 0) {
+        perror("delay: fork");
+        return;
+    }
+    job *njob = new_job(pid, d->argv[0], BACKGROUND);
+    njob->opts = d->opts;
+    add_job(jobs, njob);
+    printf("Background process running -> PID: %d, Command: %s\n", pid, d->argv[0]);
+    fflush(stdout);
+}
+
+// -----------------------------------------------------------------------
+/* manejador de SIGALRM: solo avisa al bucle principal */
+static void alarm_handler(int sig)
+{
+    int saved = errno;
+    if (write(wake[1], "", 1) < 0) { /* llena: ya hay un aviso pendiente */ }
+    errno = saved;
+}
+
+// -----------------------------------------------------------------------
+void deferred_init(job * list)
+{
+    jobs = list;
+    if (pipe2(wake, O_NONBLOCK | O_CLOEXEC) == -1) perror("deferred: pipe");
+    signal(SIGALRM, alarm_handler);
+}
+
+/* descriptor que se vuelve legible cuando vence el temporizador */
+int deferred_fd(void)
+{
+    return wake[0];
+}
+
+/* lanza (o llama) todas las entradas vencidas, con SIGCHLD y SIGALRM
+   bloqueadas. Se usa desde el bucle principal y mientras se espera a un
+   trabajo en primer plano, nunca desde un manejador. devuelve cuántos
+   comandos ha lanzado */
+int deferred_run(void)
+{
+    char buf[64];
+    sigset_t block, old;
+    struct timespec now;
+    int launched = 0;
+
+    while (read(wake[0], buf, sizeof(buf)) > 0); // se atienden todos los avisos a la vez
+    sigemptyset(&block);
+    sigaddset(&block, SIGCHLD);
+    sigaddset(&block, SIGALRM);
+    sigprocmask(SIG_BLOCK, &block, &old);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    while (heap_len > 0 && expired(heap[0], &now)) {
+        deferred *d = heap[0];
+        heap_remove(0);
+        if (d->call != NULL) d->call(d->arg);
+        else {
+            launch(d);
+            launched++;
+        }
+        if (d->period > 0) {
+            d->due.tv_sec += d->period;
+            if (expired(d, &now)) { // el shell estuvo ocupado: no se acumulan lanzamientos
+                d->due = now;
+                d->due.tv_sec += d->period;
+            }
+            heap_push(d);
+        } else {
+            free_deferred(d);
+        }
+    }
+    arm_timer();
+    sigprocmask(SIG_SETMASK, &old, NULL);
+    return launched;
+}
+
+// -----------------------------------------------------------------------
+/* programa argv para dentro de 'delay' segundos y, si period > 0, cada
+   'period' segundos a partir de entonces. devuelve el id de la entrada */
+int deferred_add(int delay, int period, char **argv, const redir_list *redirs,
+                 const launch_opts *opts)
+{
+    deferred *d = (deferred *) calloc(1, sizeof(deferred));
+    int argc = 0;
+    while (argv[argc]) argc++;
+    d->argv = (char **) malloc((argc + 1) * sizeof(char *));
+    for (int i = 0; i < argc; i++) d->argv[i] = strdup(argv[i]);
+    d->argv[argc] = NULL;
+    copy_redirections(&d->redirs, redirs);
+    d->opts = *opts;
+    d->period = period;
+    clock_gettime(CLOCK_MONOTONIC, &d->due);
+    d->due.tv_sec += delay;
+
+    mask_signal(SIGALRM, SIG_BLOCK);
+    d->id = next_id++;
+    heap_push(d);
+    if (heap[0] == d) arm_timer(); // es la nueva entrada más próxima
+    mask_signal(SIGALRM, SIG_UNBLOCK);
+    return d->id;
+}
+
+// -----------------------------------------------------------------------
+/* llama a call(arg) cada 'period' segundos (desde deferred_run, con
+   SIGCHLD bloqueada). devuelve el id para cancelarla */
+int deferred_add_call(int period, void (*call)(void *), void *arg)
+{
+    deferred *d = (deferred *) calloc(1, sizeof(deferred));
+    d->call = call;
+    d->arg = arg;
+    d->period = period;
+    clock_gettime(CLOCK_MONOTONIC, &d->due);
+    d->due.tv_sec += period;
+
+    mask_signal(SIGALRM, SIG_BLOCK);
+    d->id = next_id++;
+    ncalls++;
+    heap_push(d);
+    if (heap[0] == d) arm_timer();
+    mask_signal(SIGALRM, SIG_UNBLOCK);
+    return d->id;
+}
+
+// -----------------------------------------------------------------------
+/* elimina la entrada id si es del tipo pedido (call: de deferred_add_call).
+   devuelve 0 si no existe */
+static int cancel(int id, int call)
+{
+    int found = 0;
+    mask_signal(SIGALRM, SIG_BLOCK);
+    for (int i = 0; i < heap_len; i++) {
+        if (heap[i]->id == id) {
+            deferred *d = heap[i];
+            if ((d->call != NULL) != call) break; // el usuario no puede quitar las llamadas internas
+            heap_remove(i);
+            free_deferred(d);
+            found = 1;
+            break;
+        }
+    }
+    arm_timer();
+    mask_signal(SIGALRM, SIG_UNBLOCK);
+    return found;
+}
+
+/* jobs -c: las llamadas periódicas de otros módulos (health) no se pueden quitar */
+int deferred_cancel(int id)
+{
+    return cancel(id, 0);
+}
+
+/* elimina la llamada periódica id (deferred_add_call). devuelve 0 si no existe */
+int deferred_cancel_call(int id)
+{
+    return cancel(id, 1);
+}
+
+// -----------------------------------------------------------------------
+int deferred_count(void)
+{
+    return heap_len - ncalls;
+}
+
+// -----------------------------------------------------------------------
+/* lista las entradas por orden de lanzamiento */
+void deferred_print(void)
+{
+    mask_signal(SIGALRM, SIG_BLOCK);
+    if (heap_len - ncalls > 0) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        // copia ordenada: el montículo solo garantiza el mínimo
+        deferred **sorted = (deferred **) malloc(heap_len * sizeof(deferred *));
+        memcpy(sorted, heap, heap_len * sizeof(deferred *));
+        qsort(sorted, heap_len, sizeof(deferred *), cmp_due);
+        printf("Lanzamientos programados:\n");
+        for (int i = 0; i < heap_len; i++) {
+            deferred *d = sorted[i];
+            if (d->call != NULL) continue;
+            double left = (d->due.tv_sec - now.tv_sec) + (d->due.tv_nsec - now.tv_nsec) / 1e9;
+            printf(" [D%d] command: %s, in: %.1f s", d->id, d->argv[0], left > 0 ? left : 0);
+            if (d->period > 0) printf(", every: %d s", d->period);
+            printf("\n");
+        }
+        free(sorted);
+    }
+    mask_signal(SIGALRM, SIG_UNBLOCK);
+}
@@ -0,0 +1,46 @@
+/*--------------------------------------------------------
+UNIX Shell Project
+function prototypes and type declarations for deferred module:
+cola de lanzamientos diferidos y periódicos (delay-thread, every)
+
+Sistemas Operativos
+Grados I. Informatica, Computadores & Software
+Dept. Arquitectura de Computadores - UMA
+Iván Ballesteros Fernández - 24-25 - 2ºGCIA
+--------------------------------------------------------*/
+
+#ifndef _DEFERRED_H
+#define _DEFERRED_H
+
+#include <time.h>
+#include "job_control.h"
+
+// ----------- LANZAMIENTO PROGRAMADO -----------------------------------
+typedef struct deferred_
+{
+	int id;                /* identificador para listar y cancelar */
+	struct timespec due;   /* instante (CLOCK_MONOTONIC) en que se lanza */
+	int period;            /* segundos entre lanzamientos, 0 si es único */
+	char ** argv;          /* comando a lanzar */
+	redir_list redirs;     /* redirecciones (copia propia) */
+	launch_opts opts;
+	void (*call)(void *);  /* en lugar de lanzar argv se llama a call(arg) */
+	void * arg;
+	int heap_pos;          /* posición en el montículo */
+} deferred;
+
+// -----------------------------------------------------------------------
+//      PUBLIC FUNCTIONS
+// -----------------------------------------------------------------------
+void deferred_init(job * list);
+int deferred_fd(void);
+int deferred_run(void);
+int deferred_add(int delay, int period, char **argv, const redir_list *redirs,
+                 const launch_opts *opts);
+int deferred_add_call(int period, void (*call)(void *), void *arg);
+int deferred_cancel(int id);
+int deferred_cancel_call(int id);
+void deferred_print(void);
+int deferred_count(void);
+
+#endif
@@ -0,0 +1,212 @@
+/*--------------------------------------------------------
+UNIX Shell Project
+fastcmd module: true, false, echo y pwd dentro del shell
+
+Se usan para los comandos en primer plano sin opciones de lanzamiento.
+Solo las utilidades que no se quedan esperando: sleep o cat ejecutados
+dentro del shell no se podrían suspender con ctrl+z ni pasar a la lista
+de trabajos, así que esos se lanzan siempre como procesos.
+Las redirecciones se abren como descriptores propios del comando
+(open_redirections), sin tocar la entrada, salida y error del shell.
+Mientras se ejecutan, ctrl+c interrumpe la llamada en curso (el shell
+normalmente ignora SIGINT).
+
+Sistemas Operativos
+Grados I. Informatica, Computadores & Software
+Dept. Arquitectura de Computadores - UMA
+Iván Ballesteros Fernández - 24-25 - 2ºGCIA
+--------------------------------------------------------*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/sendfile.h>
+#include "fastcmd.h"
+
+#define COPY_CHUNK (1 << 30) /* máximo por llamada de copia */
+
+typedef int (*fastcmd_fn)(char **args, int in, int out, int err);
+
+static volatile sig_atomic_t interrupted = 0;
+
+// -----------------------------------------------------------------------
+/* escribe todo el buffer aunque write lo parta */
+static int write_all(int fd, const char *buf, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR && !interrupted) continue;
+            return -1;
+        }
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+// -----------------------------------------------------------------------
+/* copia in en out hasta fin de fichero sin pasar por memoria de usuario
+   cuando es posible: copy_file_range entre ficheros, sendfile desde un
+   fichero a cualquier cosa y splice si uno de los dos es una tubería.
+   devuelve 0 o -1 con errno */
+int copy_fd(int in, int out)
+{
+    struct stat st_in, st_out;
+    ssize_t n;
+    int method = 0; // 0 copy_file_range, 1 sendfile, 2 splice, 3 read/write
+
+    if (fstat(in, &st_in) == -1 || fstat(out, &st_out) == -1) return -1;
+    if (!S_ISREG(st_in.st_mode) || !S_ISREG(st_out.st_mode)) method = 1;
+    if (!S_ISREG(st_in.st_mode)) method = 2;
+    if (method == 2 && !S_ISFIFO(st_in.st_mode) && !S_ISFIFO(st_out.st_mode)) method = 3;
+
+    while (!interrupted) {
+        switch (method) {
+            case 0: n = copy_file_range(in, NULL, out, NULL, COPY_CHUNK, 0); break;
+            case 1: n = sendfile(out, in, NULL, COPY_CHUNK); break;
+            case 2: n = splice(in, NULL, out, NULL, COPY_CHUNK, SPLICE_F_MOVE); break;
+            default: {
+                char buf[65536];
+                n = read(in, buf, sizeof(buf));
+                if (n > 0 && write_all(out, buf, n) == -1) return -1;
+            }
+        }
+        if (n == 0) return 0;
+        if (n > 0) continue;
+        if (errno == EINTR) continue;
+        // el método no sirve para estos descriptores (otro sistema de
+        // ficheros, O_APPEND, kernel antiguo...): se prueba el siguiente
+        if (method < 3 && (errno == EXDEV || errno == EINVAL || errno == ENOSYS ||
+                           errno == EBADF || errno == EOPNOTSUPP)) {
+            method = (method == 1 && !S_ISFIFO(st_out.st_mode)) ? 3 : method + 1;
+            continue;
+        }
+        return -1;
+    }
+    errno = EINTR;
+    return -1;
+}
+
+// -----------------------------------------------------------------------
+static int fast_true(char **args, int in, int out, int err)  { return 0; }
+static int fast_false(char **args, int in, int out, int err) { return 1; }
+
+static int fast_echo(char **args, int in, int out, int err)
+{
+    int newline = 1, i = 1;
+    size_t len = 0;
+    if (args[1] && strcmp(args[1], "-n") == 0) {
+        newline = 0;
+        i = 2;
+    }
+    for (int j = i; args[j]; j++) len += strlen(args[j]) + 1;
+    char *buf = (char *) malloc(len + 1);
+    char *p = buf;
+    for (int j = i; args[j]; j++) {
+        if (j > i) *p++ = ' ';
+        size_t l = strlen(args[j]);
+        memcpy(p, args[j], l);
+        p += l;
+    }
+    if (newline) *p++ = '\n';
+    int res = write_all(out, buf, p - buf);
+    free(buf);
+    return res == -1 ? 1 : 0;
+}
+
+static int fast_pwd(char **args, int in, int out, int err)
+{
+    char cwd[PATH_MAX + 1];
+    if (getcwd(cwd, PATH_MAX) == NULL) {
+        dprintf(err, "pwd: %s\n", strerror(errno));
+        return 1;
+    }
+    strcat(cwd, "\n");
+    return write_all(out, cwd, strlen(cwd)) == -1 ? 1 : 0;
+}
+
+// -----------------------------------------------------------------------
+// flag: única opción que implementa la versión interna (solo como primer
+// argumento)
+static struct {
+    const char *name;
+    fastcmd_fn fn;
+    const char *flag;
+} fastcmds[] = {
+    { "true", fast_true, NULL },
+    { "false", fast_false, NULL },
+    { "echo", fast_echo, "-n" },
+    { "pwd", fast_pwd, NULL },
+    { NULL, NULL, NULL }
+};
+
+// -----------------------------------------------------------------------
+static int find_fastcmd(const char *name)
+{
+    for (int i = 0; fastcmds[i].name; i++) {
+        if (strcmp(fastcmds[i].name, name) == 0) return i;
+    }
+    return -1;
+}
+
+/* 1 si la versión interna entiende todos los argumentos; si no (echo -e,
+   pwd -P...) se ejecuta el programa de verdad */
+static int args_supported(int cmd, char **args)
+{
+    for (int i = 1; args[i]; i++) {
+        if (args[i][0] == '-' && args[i][1] != '\0') {
+            if (i > 1 || fastcmds[cmd].flag == NULL || strcmp(args[i], fastcmds[cmd].flag) != 0) return 0;
+        }
+    }
+    return 1;
+}
+
+/* 1 si el comando tiene versión interna que entiende sus argumentos y sus
+   redirecciones solo afectan a la entrada, salida y error estándar */
+int is_fastcmd(char **args, const redir_list *redirs)
+{
+    int cmd = find_fastcmd(args[0]);
+    for (int i = 0; i < redirs->n; i++) {
+        if (redirs->ops[i].fd > 2 || (redirs->ops[i].type == REDIR_DUP && redirs->ops[i].target > 2)) return 0;
+    }
+    return cmd >= 0 && args_supported(cmd, args);
+}
+
+static void sigint_handler(int sig)
+{
+    interrupted = 1;
+}
+
+// -----------------------------------------------------------------------
+/* ejecuta el comando con las redirecciones indicadas y devuelve su código
+   de salida (130 si se interrumpió con ctrl+c) */
+int run_fastcmd(char **args, const redir_list *redirs)
+{
+    int fds[3], res;
+
+    if (open_redirections(redirs, fds) == -1) return 1;
+
+    // sin SA_RESTART: ctrl+c corta la escritura en curso (p. ej. a una tubería llena)
+    struct sigaction sa, old;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = sigint_handler;
+    sigemptyset(&sa.sa_mask);
+    interrupted = 0;
+    sigaction(SIGINT, &sa, &old);
+
+    fflush(stdout); // lo que el shell tuviera pendiente va antes que la salida del comando
+    res = fastcmds[find_fastcmd(args[0])].fn(args, fds[0], fds[1], fds[2]);
+    if (interrupted) res = 130;
+
+    sigaction(SIGINT, &old, NULL);
+    close_redirections(fds);
+    return res;
+}
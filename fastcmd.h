@@ -0,0 +1,24 @@
+/*--------------------------------------------------------
+UNIX Shell Project
+function prototypes for fastcmd module: utilidades triviales que se
+ejecutan dentro del shell sin fork/exec
+
+Sistemas Operativos
+Grados I. Informatica, Computadores & Software
+Dept. Arquitectura de Computadores - UMA
+Iván Ballesteros Fernández - 24-25 - 2ºGCIA
+--------------------------------------------------------*/
+
+#ifndef _FASTCMD_H
+#define _FASTCMD_H
+
+#include "launch.h"
+
+// -----------------------------------------------------------------------
+//      PUBLIC FUNCTIONS
+// -----------------------------------------------------------------------
+int is_fastcmd(char **args, const redir_list *redirs);
+int run_fastcmd(char **args, const redir_list *redirs);
+int copy_fd(int in, int out);
+
+#endif
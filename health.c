@@ -0,0 +1,270 @@
+/*--------------------------------------------------------
+UNIX Shell Project
+health module: comprobaciones de vida de los trabajos respawnable
+
+Un trabajo respawnable solo se relanzaba al terminar; uno colgado seguía
+"en marcha" para siempre. Con health se le añaden comprobaciones que se
+hacen cada cierto intervalo desde el temporizador de deferred:
+  - prueba: una orden (sh -c) que debe terminar con 0 antes de la
+    siguiente comprobación; si sigue en marcha cuenta como fallo.
+  - latido: el trabajo hereda el extremo de escritura de una tubería en
+    el descriptor indicado y debe escribir algo en cada intervalo.
+  - CPU: el tiempo en CPU del líder (/proc/<pid>/schedstat) debe avanzar.
+Tras N comprobaciones fallidas seguidas se mata el grupo con SIGKILL y
+sigchld_handler lo relanza como siempre, pero lo cuenta como reinicio por
+cuelgue y no como caída.
+
+Sistemas Operativos
+Grados I. Informatica, Computadores & Software
+Dept. Arquitectura de Computadores - UMA
+Iván Ballesteros Fernández - 24-25 - 2ºGCIA
+--------------------------------------------------------*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "health.h"
+#include "deferred.h"
+
+static health *watched = NULL; // trabajos vigilados
+static pid_t orphans[64];      // pruebas matadas cuyo resultado ya no cuenta
+static int norphans = 0;
+
+// -----------------------------------------------------------------------
+void init_health_opts(health_opts *h)
+{
+    h->interval = 0; // 0: no se ha pedido ninguna comprobación
+    h->max_failures = HEALTH_FAILURES;
+    h->probe = NULL;
+    h->hb_fd = -1;
+    h->cpu = 0;
+    h->hb_pipe[0] = h->hb_pipe[1] = -1;
+    h->hb_path[0] = '\0';
+}
+
+// -----------------------------------------------------------------------
+/* interpreta la opción que hay en args[*i]:
+   -i <seg>  -n <fallos>  -p <orden>  -hb <fd>  -cpu
+   devuelve 1 si la ha consumido (avanzando *i), 0 si no es una opción
+   de health y -1 si es una opción mal formada */
+int parse_health_opt(char **args, int *i, health_opts *h)
+{
+    char *opt = args[*i];
+    char *val = args[*i + 1];
+    char *end;
+    long n = 0;
+
+    if (strcmp(opt, "-cpu") == 0) {
+        h->cpu = 1;
+        *i += 1;
+        if (h->interval == 0) h->interval = HEALTH_INTERVAL;
+        return 1;
+    }
+    if (strcmp(opt, "-i") && strcmp(opt, "-n") && strcmp(opt, "-p") && strcmp(opt, "-hb")) return 0;
+    if (val == NULL) return -1;
+    if (strcmp(opt, "-p") != 0) {
+        n = strtol(val, &end, 10);
+        if (*end || n <= 0 || n > 3600) return -1;
+    }
+
+    if (strcmp(opt, "-i") == 0) h->interval = (int) n;
+    else if (strcmp(opt, "-n") == 0) h->max_failures = (int) n;
+    else if (strcmp(opt, "-p") == 0) h->probe = val;
+    else if (n < 3) return -1; // el latido no puede tapar la entrada, salida o error
+    else h->hb_fd = (int) n;
+    if (h->interval == 0) h->interval = HEALTH_INTERVAL;
+    *i += 2;
+    return 1;
+}
+
+// -----------------------------------------------------------------------
+/* crea la tubería del latido (si se pidió) y añade a redirs la
+   redirección que la deja en el descriptor hb_fd del hijo. Se abre por
+   /proc para que también valga con el lanzador (zygote) y al relanzar.
+   devuelve 0 o -1 */
+int health_prepare(health_opts *h, redir_list *redirs)
+{
+    if (h->hb_fd < 0) return 0;
+    if (redirs->n == MAX_REDIRS || pipe2(h->hb_pipe, O_CLOEXEC) == -1) return -1;
+    fcntl(h->hb_pipe[0], F_SETFL, O_NONBLOCK);
+    snprintf(h->hb_path, sizeof(h->hb_path), "/proc/%d/fd/%d", getpid(), h->hb_pipe[1]);
+    redir_op *op = &redirs->ops[redirs->n++];
+    op->type = REDIR_OUT;
+    op->fd = h->hb_fd;
+    op->path = h->hb_path;
+    return 0;
+}
+
+/* cierra la tubería si al final no se llega a vigilar el trabajo */
+void health_discard(health_opts *h)
+{
+    if (h->hb_pipe[0] >= 0) close(h->hb_pipe[0]);
+    if (h->hb_pipe[1] >= 0) close(h->hb_pipe[1]);
+    h->hb_pipe[0] = h->hb_pipe[1] = -1;
+}
+
+// -----------------------------------------------------------------------
+/* tiempo en CPU de pid en ns; -1 si no se puede leer */
+static long long cpu_time(pid_t pid)
+{
+    char path[64], buf[128];
+    snprintf(path, sizeof(path), "/proc/%d/schedstat", pid);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0) return -1;
+    buf[n] = '\0';
+    return strtoll(buf, NULL, 10);
+}
+
+/* vacía la tubería del latido; 1 si había algo */
+static int heartbeat(health *h)
+{
+    char buf[512];
+    int beat = 0;
+    while (read(h->o.hb_pipe[0], buf, sizeof(buf)) > 0) beat = 1;
+    return beat;
+}
+
+/* lanza la orden de prueba con la salida descartada */
+static void start_probe(health *h)
+{
+    char *argv[] = { "sh", "-c", h->o.probe, NULL };
+    redir_list redirs;
+    redirs.n = 3;
+    redirs.ops[0] = (redir_op) { REDIR_IN, STDIN_FILENO, 0, "/dev/null" };
+    redirs.ops[1] = (redir_op) { REDIR_OUT, STDOUT_FILENO, 0, "/dev/null" };
+    redirs.ops[2] = (redir_op) { REDIR_DUP, STDERR_FILENO, STDOUT_FILENO, NULL };
+    pid_t pid = spawn_job(argv, NULL, &redirs);
+    h->probe_pid = (pid > 0) ? pid : 0;
+    h->probe_status = (pid > 0) ? -1 : 1; // cada resultado cuenta una sola vez
+}
+
+/* mata la prueba en marcha; su final se ignora (ya se contó como fallo) */
+static void drop_probe(health *h)
+{
+    killpg(h->probe_pid, SIGKILL);
+    if (norphans < (int) (sizeof(orphans) / sizeof(orphans[0]))) orphans[norphans++] = h->probe_pid;
+    h->probe_pid = 0;
+    h->probe_status = -1;
+}
+
+// -----------------------------------------------------------------------
+/* una comprobación (temporizador de deferred, con SIGCHLD bloqueada) */
+static void check(void *arg)
+{
+    health *h = (health *) arg;
+    job *j = h->owner;
+    int ok = 1;
+
+    if (j->state != RESPAWNABLE || h->killed) return; // detenido, en primer plano o ya relanzándose
+
+    if (h->o.probe) {
+        if (h->probe_pid != 0) { // la anterior no ha terminado a tiempo
+            drop_probe(h);
+            ok = 0;
+        } else if (h->probe_status > 0) {
+            ok = 0;
+        }
+        start_probe(h);
+    }
+    if (h->o.hb_fd >= 0 && !heartbeat(h)) ok = 0;
+    if (h->o.cpu) {
+        long long ns = cpu_time(j->pgid);
+        if (h->cpu_pid == j->pgid && ns >= 0 && (unsigned long long) ns == h->cpu_ns) ok = 0;
+        h->cpu_pid = j->pgid;
+        h->cpu_ns = (unsigned long long) ns;
+    }
+
+    h->failures = ok ? 0 : h->failures + 1;
+    if (h->failures >= h->o.max_failures) {
+        printf("\nRespawnable job %d (%s) not responding after %d checks: killed\n",
+               j->pgid, j->command, h->failures);
+        fflush(stdout);
+        h->killed = j->pgid;
+        killpg(j->pgid, SIGKILL);
+    }
+}
+
+// -----------------------------------------------------------------------
+/* empieza a vigilar item con las opciones h (se queda con la tubería) */
+void health_attach(job *item, health_opts *h)
+{
+    health *w = (health *) calloc(1, sizeof(health));
+    if (w == NULL) {
+        health_discard(h);
+        return;
+    }
+    w->o = *h;
+    if (h->probe) w->o.probe = strdup(h->probe);
+    w->owner = item;
+    w->probe_status = -1;
+    w->redirs.n = 0;
+    if (h->hb_fd >= 0) {
+        w->redirs.n = 1;
+        w->redirs.ops[0] = (redir_op) { REDIR_OUT, h->hb_fd, 0, w->o.hb_path };
+    }
+    item->health = w;
+    w->next = watched;
+    watched = w;
+    w->timer = deferred_add_call(h->interval, check, w);
+}
+
+/* redirecciones con las que hay que relanzar item (NULL si ninguna) */
+const redir_list * health_redirs(job *item)
+{
+    return (item->health && item->health->redirs.n > 0) ? &item->health->redirs : NULL;
+}
+
+/* sigchld_handler, al relanzar: 1 si el grupo pgid lo mató health por
+   no responder (reinicio por cuelgue), 0 si el trabajo se cayó solo.
+   La nueva instancia empieza sin fallos acumulados */
+int health_was_hung(job *item, pid_t pgid)
+{
+    health *h = item->health;
+    if (h == NULL) return 0;
+    h->failures = 0;
+    if (h->killed != pgid) return 0;
+    h->killed = 0;
+    return 1;
+}
+
+// -----------------------------------------------------------------------
+/* sigchld_handler: devuelve 1 si pid es una orden de prueba (y la anota) */
+int health_child_exited(pid_t pid, int wstatus)
+{
+    for (int i = 0; i < norphans; i++) {
+        if (orphans[i] != pid) continue;
+        if (!WIFSTOPPED(wstatus) && !WIFCONTINUED(wstatus)) orphans[i] = orphans[--norphans];
+        return 1;
+    }
+    for (health *h = watched; h; h = h->next) {
+        if (h->probe_pid != pid) continue;
+        if (WIFSTOPPED(wstatus) || WIFCONTINUED(wstatus)) return 1;
+        h->probe_status = (WIFEXITED(wstatus) && WEXITSTATUS(wstatus) == 0) ? 0 : 1;
+        h->probe_pid = 0;
+        return 1;
+    }
+    return 0;
+}
+
+// -----------------------------------------------------------------------
+/* deja de vigilar item (delete_job) */
+void health_forget(job *item)
+{
+    health *h = item->health, **p = &watched;
+    if (h == NULL) return;
+    while (*p && *p != h) p = &(*p)->next;
+    if (*p) *p = h->next;
+    deferred_cancel_call(h->timer);
+    if (h->probe_pid != 0) drop_probe(h);
+    health_discard(&h->o);
+    free(h->o.probe);
+    free(h);
+    item->health = NULL;
+}
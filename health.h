@@ -0,0 +1,61 @@
+/*--------------------------------------------------------
+UNIX Shell Project
+function prototypes and type declarations for health module:
+comprobaciones de vida de los trabajos respawnable
+
+Sistemas Operativos
+Grados I. Informatica, Computadores & Software
+Dept. Arquitectura de Computadores - UMA
+Iván Ballesteros Fernández - 24-25 - 2ºGCIA
+--------------------------------------------------------*/
+
+#ifndef _HEALTH_H
+#define _HEALTH_H
+
+#include "job_control.h"
+
+#define HEALTH_INTERVAL 5 /* segundos entre comprobaciones por defecto */
+#define HEALTH_FAILURES 3 /* fallos seguidos antes de relanzar por defecto */
+
+// ----------- OPCIONES DE health ---------------------------------------
+typedef struct health_opts_
+{
+	int interval;      /* segundos entre comprobaciones */
+	int max_failures;  /* fallos seguidos que se toleran */
+	char * probe;      /* orden de prueba (sh -c), NULL si no hay */
+	int hb_fd;         /* descriptor del latido en el hijo, -1 si no hay */
+	int cpu;           /* comprobar que el tiempo de CPU avanza */
+	int hb_pipe[2];    /* tubería del latido (health_prepare) */
+	char hb_path[64];  /* /proc/<shell>/fd/<escritura> */
+} health_opts;
+
+// ----------- ESTADO DE UN TRABAJO VIGILADO ----------------------------
+typedef struct health_
+{
+	health_opts o;
+	job * owner;
+	int timer;                 /* entrada del temporizador (deferred) */
+	int failures;              /* comprobaciones fallidas seguidas */
+	pid_t probe_pid;           /* prueba en marcha, 0 si no hay */
+	int probe_status;          /* resultado de la última prueba, -1 si ninguna */
+	pid_t cpu_pid;             /* proceso de la última muestra de CPU */
+	unsigned long long cpu_ns; /* tiempo en CPU en esa muestra */
+	pid_t killed;              /* grupo matado por no responder, 0 si no */
+	redir_list redirs;         /* latido, para los relanzamientos */
+	struct health_ *next;
+} health;
+
+// -----------------------------------------------------------------------
+//      PUBLIC FUNCTIONS
+// -----------------------------------------------------------------------
+void init_health_opts(health_opts *h);
+int parse_health_opt(char **args, int *i, health_opts *h);
+int health_prepare(health_opts *h, redir_list *redirs);
+void health_discard(health_opts *h);
+void health_attach(job *item, health_opts *h);
+const redir_list * health_redirs(job *item);
+int health_was_hung(job *item, pid_t pgid);
+int health_child_exited(pid_t pid, int wstatus);
+void health_forget(job *item);
+
+#endif
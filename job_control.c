@@ -13,77 +13,118 @@ Some code adapted from "Fundamentos de Sistemas Operativos", Silberschatz et al.
 #include <stdlib.h>
 #include <string.h>
 #include <malloc.h>
+#include <errno.h>
+#include <poll.h>
 #include "job_control.h"
+#include "tokenizer.h"
+#include "jobtop.h"
+#include "health.h"
+#include "deferred.h"
+
+char* status_strings[] = { "Suspended", "Signaled", "Exited", "Continued"};
+char* state_strings[] = { "Foreground", "Background", "Stopped", "Respawnable"};
 #define MAX_LINE 256 /* Longitud máxima de línea permitida por comando */
 
 // -----------------------------------------------------------------------
 //  get_command() reads in the next command line, separating it into distinct tokens
-//  using whitespace as delimiters. setup() sets the args parameter as a 
-//  null-terminated string.
+//  with tokenize_line() (whitespace as delimiters, quotes, backslash escapes and
+//  $VAR and wildcard expansion). *args is set to an argv owned by the tokenizer,
+//  sized for the expanded line and valid until the next call.
+//  If read() returns more than one line (piped scripts) the remaining ones are
+//  kept in inputBuffer and returned by the next calls.
+//  While waiting for input, wake_run() is called each time wake_fd becomes
+//  readable (expired timers of the deferred module), see set_input_wakeup().
 // -----------------------------------------------------------------------
 
-void get_command(char *inputBuffer, int size, char *args[], int *background, int *respawnable)
+static char *pending_buf = NULL; /* buffer of the last get_command call */
+static int pending = 0;          /* # of bytes already read that belong to the next lines */
+static int pending_off = 0;      /* where they start in pending_buf */
+static int wake_fd = -1;         /* also watched while waiting for input, -1 if none */
+static void (*wake_run)(void);   /* called when wake_fd is readable */
+
+void set_input_wakeup(int fd, void (*run)(void))
+{
+    wake_fd = fd;
+    wake_run = run;
+}
+
+void get_command(char *inputBuffer, int size, char ***args, int *background, int *respawnable)
 {
-    int length; /* # of characters in the command line */
-    int i;      /* loop index for accessing inputBuffer array */
-    int start;  /* index where beginning of next command parameter is */
-    int ct = 0; /* index of where to place the next parameter into args[] */
+    int length;                 /* # of characters in the command line */
+    char *eol;
 
     *background=0;
+    *respawnable=0;
+    pending_buf = inputBuffer;
 
-    /* read what the user enters on the command line */
-    length = read(STDIN_FILENO, inputBuffer, size);  
-
-    start = -1;
-    if (length == 0) {
-        printf("\nBye\n");
-        exit(0);            /* ^d was entered, end of user command stream */
-    } 
-    if (length < 0) {
-        perror("error reading the command");
-        exit(-1);           /* terminate with error code of -1 */
-    }
-    /* examine every character in the inputBuffer */
-    for (i = 0; i < length; i++) { 
-        switch (inputBuffer[i]) {
-        case ' ':
-        case '\t':               /* argument separators */
-            if(start != -1) {
-                args[ct] = &inputBuffer[start];    /* set up pointer */
-                ct++;
+    /* lines left from the previous read go first */
+    if (pending > 0) memmove(inputBuffer, inputBuffer + pending_off, pending);
+    length = pending;
+    eol = (pending > 0) ? memchr(inputBuffer, '\n', pending) : NULL;
+    pending = 0;
+
+    if (eol == NULL) {
+        /* wait for input, handling the wake-ups that arrive in the meantime */
+        while (wake_fd >= 0) {
+            struct pollfd fds[2] = { { STDIN_FILENO, POLLIN, 0 }, { wake_fd, POLLIN, 0 } };
+            if (poll(fds, 2, -1) == -1) {
+                if (errno == EINTR) continue; /* SIGCHLD */
+                break;
             }
-            inputBuffer[i] = '\0'; /* add a null char; make a C string */
-            start = -1;
+            if (fds[1].revents & POLLIN) wake_run();
+            if (fds[0].revents) break;
+        }
+        /* read what the user enters on the command line (one byte is left for the '\0') */
+        int n = read(STDIN_FILENO, inputBuffer + length, size - 1 - length);
+        if (n == 0 && length == 0) {
+            printf("\nBye\n");
+            exit(0);            /* ^d was entered, end of user command stream */
+        }
+        if (n < 0) {
+            perror("error reading the command");
+            exit(-1);           /* terminate with error code of -1 */
+        }
+        length += n;
+        eol = memchr(inputBuffer, '\n', length);
+    }
+    if (eol != NULL) {
+        pending_off = eol - inputBuffer + 1;
+        pending = length - pending_off;
+        length = eol - inputBuffer;
+    }
+
+    switch (tokenize_line(inputBuffer, length, args, background, respawnable)) {
+        case TOK_ERR_QUOTE:
+            fprintf(stderr, "syntax error: unterminated quote\n");
+            (*args)[0] = NULL;
             break;
-        case '\n':                 /* should be the final char examined */
-            if (start != -1) {
-                args[ct] = &inputBuffer[start];     
-                ct++;
-            }
-            inputBuffer[i] = '\0';
-            args[ct] = NULL; /* no more arguments to this command */
+        case TOK_ERR_SUBST:
+            fprintf(stderr, "syntax error: bad substitution\n");
+            (*args)[0] = NULL;
             break;
-        default :             /* some other character */
-            if (inputBuffer[i] == '&' || inputBuffer[i] == '+') { // background indicator
-                if (inputBuffer[i] == '+') *respawnable = 1;
-                *background = 1;
-                if (start != -1) {
-                    args[ct] = &inputBuffer[start];     
-                    ct++;
-                }
-                inputBuffer[i] = '\0';
-                args[ct] = NULL; /* no more arguments to this command */
-                i = length; // make sure the for loop ends now
-            }
-            else if (start == -1) {
-                start = i;  // start of new argument
-            }
-        }  // end switch
-    }  // end for   
-    args[ct] = NULL; /* just in case the input line was > MAXLINE */
+    }
 } 
 
 
+// -----------------------------------------------------------------------
+//  read_input() reads from the shell's standard input for builtins that
+//  consume it (parmap): bytes get_command() already read past the current
+//  line are returned first, so piped scripts do not lose them.
+// -----------------------------------------------------------------------
+
+int read_input(char *buf, int size)
+{
+    if (pending > 0) {
+        int n = (pending < size) ? pending : size;
+        memcpy(buf, pending_buf + pending_off, n);
+        pending_off += n;
+        pending -= n;
+        return n;
+    }
+    return read(STDIN_FILENO, buf, size);
+}
+
+
 // -----------------------------------------------------------------------
 /* devuelve puntero a un nodo con sus valores inicializados,
 devuelve NULL si no pudo realizarse la reserva de memoria*/
@@ -95,19 +136,165 @@ job * new_job(pid_t pid, const char * command, enum job_state state)
     aux->state = state;
     aux->command = strdup(command);
     aux->next = NULL;
+    aux->prev = NULL;
+    aux->args = NULL;
+    aux->sample = NULL;
+    aux->team = 0;
+    aux->mark = 0;
+    aux->state_prev = aux->state_next = NULL;
+    aux->team_prev = aux->team_next = NULL;
+    aux->pid_next = NULL;
+    aux->index = NULL;
+    aux->health = NULL;
+    aux->crash_restarts = aux->hang_restarts = 0;
+    init_launch_opts(&aux->opts);
     return aux;
 }
 
+// -----------------------------------------------------------------------
+/* índices de la lista: la cabecera guarda, por estado y por equipo, una
+lista doblemente enlazada de sus trabajos y una tabla hash por pgid, de
+modo que las consultas (jobspec, sigchld_handler) cuestan lo que ocupan
+los trabajos que devuelven y no lo que ocupa la lista entera.
+Todo cambio de state o pgid de un trabajo de la lista debe pasar por
+set_job_state()/set_job_pgid() para que los índices sigan al día */
+
+static job_index * list_index(job * list)
+{
+    if (list->index == NULL) list->index = (job_index *) calloc(1, sizeof(job_index));
+    return list->index;
+}
+
+static job ** pid_bucket(job_index * idx, pid_t pid)
+{
+    return &idx->by_pid[(unsigned) pid % JOB_PID_BUCKETS];
+}
+
+static void index_pid(job_index * idx, job * item)
+{
+    job ** b = pid_bucket(idx, item->pgid);
+    item->pid_next = *b;
+    *b = item;
+}
+
+static void unindex_pid(job_index * idx, job * item)
+{
+    job ** b = pid_bucket(idx, item->pgid);
+    while (*b != NULL && *b != item) b = &(*b)->pid_next;
+    if (*b != NULL) *b = item->pid_next;
+    item->pid_next = NULL;
+}
+
+static void index_state(job_index * idx, job * item)
+{
+    job ** head = &idx->by_state[item->state];
+    item->state_prev = NULL;
+    item->state_next = *head;
+    if (*head != NULL) (*head)->state_prev = item;
+    *head = item;
+    idx->count[item->state]++;
+}
+
+static void unindex_state(job_index * idx, job * item)
+{
+    if (item->state_prev != NULL) item->state_prev->state_next = item->state_next;
+    else idx->by_state[item->state] = item->state_next;
+    if (item->state_next != NULL) item->state_next->state_prev = item->state_prev;
+    item->state_prev = item->state_next = NULL;
+    idx->count[item->state]--;
+}
+
+static void index_team(job_index * idx, job * item)
+{
+    if (item->team <= 0 || item->team > idx->nteams) return;
+    job ** head = &idx->teams[item->team];
+    item->team_prev = NULL;
+    item->team_next = *head;
+    if (*head != NULL) (*head)->team_prev = item;
+    *head = item;
+}
+
+static void unindex_team(job_index * idx, job * item)
+{
+    if (item->team <= 0 || item->team > idx->nteams) return;
+    if (item->team_prev != NULL) item->team_prev->team_next = item->team_next;
+    else idx->teams[item->team] = item->team_next;
+    if (item->team_next != NULL) item->team_next->team_prev = item->team_prev;
+    item->team_prev = item->team_next = NULL;
+}
+
+static void index_job(job * list, job * item)
+{
+    job_index * idx = list_index(list);
+    index_pid(idx, item);
+    index_state(idx, item);
+    index_team(idx, item);
+}
+
+// -----------------------------------------------------------------------
+/* cambia el estado de un trabajo de la lista moviéndolo de índice */
+void set_job_state(job * list, job * item, enum job_state state)
+{
+    if (item->state == state) return;
+    unindex_state(list_index(list), item);
+    item->state = state;
+    index_state(list_index(list), item);
+}
+
+// -----------------------------------------------------------------------
+/* cambia el pgid de un trabajo de la lista (respawn) */
+void set_job_pgid(job * list, job * item, pid_t pgid)
+{
+    unindex_pid(list_index(list), item);
+    item->pgid = pgid;
+    index_pid(list_index(list), item);
+}
+
+// -----------------------------------------------------------------------
+/* reserva un id de equipo para los trabajos de un bgteam, -1 si no hay memoria */
+int new_team(job * list)
+{
+    job_index * idx = list_index(list);
+    job ** teams = (job **) realloc(idx->teams, (idx->nteams + 2) * sizeof(job *));
+    if (teams == NULL) return -1;
+    idx->teams = teams;
+    idx->nteams++;
+    idx->teams[idx->nteams] = NULL;
+    return idx->nteams;
+}
+
+// -----------------------------------------------------------------------
+/* primeros trabajos de un estado o de un equipo; el resto se recorre con
+state_next y team_next */
+job * first_in_state(job * list, enum job_state state)
+{
+    return list_index(list)->by_state[state];
+}
+
+job * first_in_team(job * list, int team)
+{
+    job_index * idx = list_index(list);
+    if (team <= 0 || team > idx->nteams) return NULL;
+    return idx->teams[team];
+}
+
+int count_in_state(job * list, enum job_state state)
+{
+    return list_index(list)->count[state];
+}
+
+// -----------------------------------------------------------------------
+/* inserta elemento en la cabeza de la lista guardando una copia de sus argumentos */
 void add_resp_job (job *list, job *item, char **args)
 {
-    job * aux = list->next;
-    item->args = (char**)malloc(MAX_LINE*sizeof(char)); //reservamos mem para los args
-    list->next = item;
-    item->next = aux;
+    int n = 0;
+    while (args[n]) n++;
+    item->args = (char**)malloc((n + 1)*sizeof(char *)); //reservamos mem para los args
     for (int i=0; args[i]; i++){
     	item->args[i] = strdup(args[i]); //strdup hace una copia de la cadena de texto
     }
-    list->pgid++;
+    item->args[n] = NULL;
+    add_job(list, item);
 }
 
 // -----------------------------------------------------------------------
@@ -117,6 +304,9 @@ void add_job (job * list, job * item)
     job * aux = list->next;
     list->next = item;
     item->next = aux;
+    item->prev = list;
+    if (aux != NULL) aux->prev = item;
+    index_job(list, item);
     list->pgid++;
 }
 
@@ -125,10 +315,19 @@ void add_job (job * list, job * item)
 devuelve 0 si no pudo realizarse con exito */
 int delete_job(job * list, job * item)
 {
-    job * aux = list;
-    while ((aux->next != NULL) && (aux->next != item)) aux = aux->next;
-    if (aux->next == NULL) return 0;
-    aux->next = item->next;
+    if (item->prev == NULL || item->prev->next != item) return 0; // no está en la lista
+    item->prev->next = item->next;
+    if (item->next != NULL) item->next->prev = item->prev;
+    job_index * idx = list_index(list);
+    unindex_pid(idx, item);
+    unindex_state(idx, item);
+    unindex_team(idx, item);
+    jobtop_forget(item); // cierra los fds de /proc que tuviera abiertos
+    health_forget(item); // y deja de vigilarlo
+    if (item->args != NULL) {
+        for (int i = 0; item->args[i]; i++) free(item->args[i]);
+        free(item->args);
+    }
     free(item->command);
     free(item);
     list->pgid--;
@@ -139,9 +338,9 @@ int delete_job(job * list, job * item)
 devuelve NULL si no lo encuentra */
 job * get_item_bypid(job * list, pid_t pid)
 {
-    job * aux = list;
-    while ((aux->next != NULL) && (aux->next->pgid != pid)) aux = aux->next;
-    return aux->next;
+    job * aux = *pid_bucket(list_index(list), pid);
+    while (aux != NULL && aux->pgid != pid) aux = aux->pid_next;
+    return aux;
 }
 // -----------------------------------------------------------------------
 job * get_item_bypos( job * list, int n)
@@ -157,8 +356,11 @@ job * get_item_bypos( job * list, int n)
 /*imprime una linea en el terminal con los datos del elemento: pid, nombre ... */
 void print_item(job * item)
 {
-
-    printf("pid: %d, command: %s, state: %s\n", item->pgid, item->command, state_strings[item->state]);
+    char sched[64];
+    format_launch_opts(item->pgid, sched, sizeof(sched)); // valores efectivos del lider del grupo
+    printf("pid: %d, command: %s, state: %s, %s", item->pgid, item->command, state_strings[item->state], sched);
+    if (item->state == RESPAWNABLE) printf(", restarts: %d crash, %d hang", item->crash_restarts, item->hang_restarts);
+    printf("\n");
 }
 
 // -----------------------------------------------------------------------
@@ -196,6 +398,44 @@ enum status analyze_status(int status, int *info)
     return EXITED;
 }
 
+// -----------------------------------------------------------------------
+/* espera en primer plano: el llamante tiene SIGCHLD bloqueada desde antes
+   de crear (o reanudar) el trabajo. Se espera en sigsuspend, así que
+   sigchld_handler sigue recogiendo los demás trabajos y entrega el estado
+   de este con foreground_reaped(), y los lanzamientos programados que
+   venzan mientras tanto se hacen igualmente. devuelve pid con su estado
+   (terminado o suspendido) en *wstatus */
+static volatile pid_t fg_pid = 0;
+static volatile int fg_done, fg_status;
+
+pid_t wait_foreground(pid_t pid, int *wstatus)
+{
+    sigset_t wait_mask;
+    sigprocmask(SIG_BLOCK, NULL, &wait_mask);
+    sigdelset(&wait_mask, SIGCHLD);
+    sigdelset(&wait_mask, SIGALRM);
+    fg_done = 0;
+    fg_pid = pid;
+    while (!fg_done) {
+        sigsuspend(&wait_mask);
+        deferred_run();
+    }
+    fg_pid = 0;
+    *wstatus = fg_status;
+    return pid;
+}
+
+/* sigchld_handler: devuelve 1 si pid es el trabajo en primer plano (y
+   guarda su estado para wait_foreground) */
+int foreground_reaped(pid_t pid, int wstatus)
+{
+    if (fg_pid == 0 || pid != fg_pid) return 0;
+    if (WIFCONTINUED(wstatus)) return 1;
+    fg_status = wstatus;
+    fg_done = 1;
+    return 1;
+}
+
 // -----------------------------------------------------------------------
 // cambia la accion de las seÃ±ales relacionadas con el terminal
 void terminal_signals(void (*func) (int))
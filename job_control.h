@@ -22,12 +22,29 @@ Some code adapted from "Fundamentos de Sistemas Operativos", Silberschatz et al.
 #include <signal.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include "launch.h"
 
 // ----------- ENUMERATIONS ---------------------------------------------
 enum status { SUSPENDED, SIGNALED, EXITED, CONTINUED};
 enum job_state { FOREGROUND, BACKGROUND, STOPPED, RESPAWNABLE };
-static char* status_strings[] = { "Suspended", "Signaled", "Exited", "Continued"};
-static char* state_strings[] = { "Foreground", "Background", "Stopped", "Respawnable"};
+extern char* status_strings[]; /* nombres de enum status (job_control.c) */
+extern char* state_strings[];  /* nombres de enum job_state */
+
+// ----------- MUESTRA DE RECURSOS (jobtop) -----------------------------
+typedef struct proc_sample_
+{
+	pid_t pid;              /* proceso al que pertenecen los fds */
+	int sched_fd;           /* /proc/<pid>/schedstat abierto, -1 si no */
+	int stat_fd;            /* /proc/<pid>/stat abierto, -1 si no */
+	int io_fd;              /* /proc/<pid>/io abierto, -1 si no */
+	int valid;              /* hay una muestra anterior con la que comparar */
+	unsigned long long run_ns;       /* tiempo en CPU del hilo principal (schedstat) */
+	unsigned long long ticks;        /* utime + stime */
+	unsigned long long rchar, wchar; /* bytes leídos y escritos */
+	long rss_kb, threads;
+	int has_io;             /* io se pudo leer (procesos de otro usuario no) */
+	struct timespec when;   /* instante de la muestra (CLOCK_MONOTONIC) */
+} proc_sample;
 
 // ----------- JOB TYPE FOR JOB LIST ------------------------------------
 typedef struct job_
@@ -36,21 +53,55 @@ typedef struct job_
 	char * command; /* program name */
 	enum job_state state;
 	struct job_ *next; /* next job in the list */
+	struct job_ *prev; /* previous job (the list head for the first one) */
 	char ** args; /* arguments for respawnable */
+	launch_opts opts; /* nice, sched e ioprio con los que se lanza */
+	proc_sample * sample; /* última muestra de jobtop, NULL si no se ha muestreado */
+	int team; /* equipo de bgteam al que pertenece, 0 si ninguno */
+	unsigned mark; /* marca de la última consulta que lo seleccionó (jobspec) */
+	struct job_ *state_prev, *state_next; /* índice por estado */
+	struct job_ *team_prev, *team_next; /* índice por equipo */
+	struct job_ *pid_next; /* cadena de la tabla hash por pgid */
+	struct job_index_ *index; /* solo en la cabecera de la lista: índices */
+	struct health_ *health; /* comprobaciones de vida (health), NULL si no tiene */
+	int crash_restarts; /* relanzamientos porque el trabajo terminó */
+	int hang_restarts;  /* relanzamientos porque health lo mató */
 	/* Add here new fields if required */
 } job;
 
+// ----------- ÍNDICES DE LA LISTA DE TRABAJOS --------------------------
+#define JOB_PID_BUCKETS 4096 /* cubetas de la tabla hash por pgid */
+
+typedef struct job_index_
+{
+	job *by_state[4];      /* primer trabajo de cada estado */
+	int count[4];          /* trabajos en cada estado */
+	job *by_pid[JOB_PID_BUCKETS];
+	job **teams;           /* primer miembro de cada equipo, indexado por id */
+	int nteams;            /* ids de equipo repartidos (el 0 no se usa) */
+} job_index;
+
 // -----------------------------------------------------------------------
 //      PUBLIC FUNCTIONS
 // -----------------------------------------------------------------------
-void get_command(char inputBuffer[], int size, char *args[],int *background, int *respawnable);
+void get_command(char inputBuffer[], int size, char ***args,int *background, int *respawnable);
+int read_input(char *buf, int size);
+void set_input_wakeup(int fd, void (*run)(void));
 job * new_job(pid_t pid, const char * command, enum job_state state);
 void add_job (job * list, job * item);
 void add_resp_job (job *list, job *item, char **args);
 int delete_job(job * list, job * item);
 job * get_item_bypid(job * list, pid_t pid);
 job * get_item_bypos(job * list, int n);
+void set_job_state(job * list, job * item, enum job_state state);
+void set_job_pgid(job * list, job * item, pid_t pgid);
+int new_team(job * list);
+job * first_in_state(job * list, enum job_state state);
+job * first_in_team(job * list, int team);
+int count_in_state(job * list, enum job_state state);
 enum status analyze_status(int status, int *info);
+pid_t wait_foreground(pid_t pid, int *wstatus);
+int foreground_reaped(pid_t pid, int wstatus);
 
 // -----------------------------------------------------------------------
 //      PRIVATE FUNCTIONS PROTOTYPES: BETTER USED THROUGH MACROS BELOW
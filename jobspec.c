@@ -0,0 +1,190 @@
+/*--------------------------------------------------------
+UNIX Shell Project
+jobspec module: selección de trabajos para kill, stop y cont
+
+  %n        trabajo en la posición n de `jobs` (%% o %+ es el primero)
+  %cmd      todos los trabajos cuyo comando es cmd
+  %T<id>    todos los miembros del equipo <id> de bgteam
+  pid       el trabajo cuyo grupo es pid
+  -a estado todos los trabajos en ese estado (foreground, background,
+            stopped, respawnable; basta un prefijo)
+
+Los equipos y los estados se sacan de los índices de la lista de trabajos
+(first_in_team, first_in_state), así que seleccionarlos cuesta lo que
+ocupan los trabajos elegidos. %cmd sí recorre la lista entera.
+Selección y envío se hacen con SIGCHLD bloqueada: las señales salen en una
+sola pasada de killpg sobre los trabajos ya reunidos y ninguno desaparece
+de la lista a medias.
+
+Sistemas Operativos
+Grados I. Informatica, Computadores & Software
+Dept. Arquitectura de Computadores - UMA
+Iván Ballesteros Fernández - 24-25 - 2ºGCIA
+--------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include "jobspec.h"
+
+static unsigned last_mark = 0; // marca de la última selección creada
+
+static const struct { const char *name; int sig; } signals[] = {
+    {"HUP", SIGHUP}, {"INT", SIGINT}, {"QUIT", SIGQUIT}, {"KILL", SIGKILL},
+    {"USR1", SIGUSR1}, {"USR2", SIGUSR2}, {"PIPE", SIGPIPE}, {"ALRM", SIGALRM},
+    {"TERM", SIGTERM}, {"CONT", SIGCONT}, {"STOP", SIGSTOP}, {"TSTP", SIGTSTP},
+    {"TTIN", SIGTTIN}, {"TTOU", SIGTTOU}, {"XCPU", SIGXCPU}, {"WINCH", SIGWINCH},
+};
+
+// -----------------------------------------------------------------------
+void jobset_init(job_set *set)
+{
+    set->items = NULL;
+    set->n = set->cap = 0;
+    if (++last_mark == 0) last_mark = 1; // el 0 es la marca de los trabajos nuevos
+    set->mark = last_mark;
+}
+
+void jobset_free(job_set *set)
+{
+    free(set->items);
+    set->items = NULL;
+    set->n = set->cap = 0;
+}
+
+/* añade un trabajo si no estaba ya en la selección; 1 si se añadió */
+static int jobset_push(job_set *set, job *item)
+{
+    if (item->mark == set->mark) return 0;
+    if (set->n == set->cap) {
+        int cap = set->cap ? set->cap * 2 : 16;
+        job **items = realloc(set->items, cap * sizeof(job *));
+        if (items == NULL) return 0;
+        set->items = items;
+        set->cap = cap;
+    }
+    item->mark = set->mark;
+    set->items[set->n++] = item;
+    return 1;
+}
+
+// -----------------------------------------------------------------------
+/* añade a la selección los trabajos que indica spec. Devuelve cuántos
+trabajos nombra (0 si ninguno) o -1 si spec está mal formado */
+int jobspec_add(job *list, const char *spec, job_set *set)
+{
+    char *end;
+    int found = 0;
+
+    if (spec[0] != '%') { // pid del líder del grupo
+        long pid = strtol(spec, &end, 10);
+        if (*spec == '\0' || *end != '\0' || pid <= 0) return -1;
+        job *item = get_item_bypid(list, (pid_t) pid);
+        if (item == NULL) return 0;
+        jobset_push(set, item);
+        return 1;
+    }
+    spec++;
+    if (*spec == '\0') return -1;
+
+    if (strcmp(spec, "%") == 0 || strcmp(spec, "+") == 0) spec = "1";
+
+    if (spec[0] >= '0' && spec[0] <= '9') { // %n: posición en la lista
+        long n = strtol(spec, &end, 10);
+        if (*end != '\0') return -1;
+        job *item = (n > 0 && n <= list_size(list)) ? get_item_bypos(list, (int) n) : NULL;
+        if (item == NULL) return 0;
+        jobset_push(set, item);
+        return 1;
+    }
+
+    if (spec[0] == 'T' && spec[1] >= '0' && spec[1] <= '9') { // %T<id>: equipo de bgteam
+        long team = strtol(spec + 1, &end, 10);
+        if (*end == '\0') {
+            for (job *j = first_in_team(list, (int) team); j; j = j->team_next) {
+                jobset_push(set, j);
+                found++;
+            }
+            return found;
+        }
+    }
+
+    for (job *j = list->next; j; j = j->next) { // %cmd
+        if (strcmp(j->command, spec) == 0) {
+            jobset_push(set, j);
+            found++;
+        }
+    }
+    return found;
+}
+
+// -----------------------------------------------------------------------
+/* 1 si name es un estado (o un prefijo suyo) para -a */
+int jobspec_is_state(const char *name)
+{
+    size_t len = strlen(name);
+    for (int s = FOREGROUND; s <= RESPAWNABLE; s++) {
+        if (len > 0 && strncasecmp(name, state_strings[s], len) == 0) return 1;
+    }
+    return 0;
+}
+
+/* añade todos los trabajos en el estado name (o un prefijo suyo, sin
+distinguir mayúsculas). Devuelve cuántos hay o -1 si no es un estado */
+int jobspec_add_state(job *list, const char *name, job_set *set)
+{
+    size_t len = strlen(name);
+    int found = 0;
+
+    for (int s = FOREGROUND; s <= RESPAWNABLE; s++) {
+        if (len == 0 || strncasecmp(name, state_strings[s], len) != 0) continue;
+        for (job *j = first_in_state(list, s); j; j = j->state_next) {
+            jobset_push(set, j);
+            found++;
+        }
+        return found;
+    }
+    return -1;
+}
+
+// -----------------------------------------------------------------------
+/* "9", "KILL" o "SIGKILL" -> número de señal; -1 si no se reconoce */
+int jobspec_parse_signal(const char *name)
+{
+    char *end;
+    if (name[0] >= '0' && name[0] <= '9') {
+        long sig = strtol(name, &end, 10);
+        return (*end == '\0' && sig < NSIG) ? (int) sig : -1;
+    }
+    if (strncasecmp(name, "SIG", 3) == 0) name += 3;
+    for (size_t i = 0; i < sizeof(signals) / sizeof(signals[0]); i++) {
+        if (strcasecmp(name, signals[i].name) == 0) return signals[i].sig;
+    }
+    return -1;
+}
+
+// -----------------------------------------------------------------------
+/* envía sig al grupo de cada trabajo de la selección. Los respawnables que
+reciben una señal de terminación pasan antes a background para que
+sigchld_handler no los relance. Se llama con SIGCHLD bloqueada desde que se
+hizo la selección. Devuelve cuántos grupos recibieron la señal */
+int jobset_signal(job *list, job_set *set, int sig)
+{
+    int ok = 0;
+    int ends = (sig == SIGKILL || sig == SIGTERM || sig == SIGINT || sig == SIGHUP || sig == SIGQUIT);
+
+    if (ends) {
+        for (int i = 0; i < set->n; i++) {
+            if (set->items[i]->state == RESPAWNABLE) set_job_state(list, set->items[i], BACKGROUND);
+        }
+    }
+    for (int i = 0; i < set->n; i++) {
+        if (killpg(set->items[i]->pgid, sig) == 0) ok++;
+        else fprintf(stderr, "kill: %d: %s\n", set->items[i]->pgid, strerror(errno));
+        // un trabajo detenido no atiende la señal hasta que se reanuda
+        if (ends && sig != SIGKILL && set->items[i]->state == STOPPED) killpg(set->items[i]->pgid, SIGCONT);
+    }
+    return ok;
+}
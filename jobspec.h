@@ -0,0 +1,37 @@
+/*--------------------------------------------------------
+UNIX Shell Project
+function prototypes and type declarations for jobspec module:
+selección de trabajos (%n, %cmd, %T<equipo>, estados) y envío de señales
+a todos ellos
+
+Sistemas Operativos
+Grados I. Informatica, Computadores & Software
+Dept. Arquitectura de Computadores - UMA
+Iván Ballesteros Fernández - 24-25 - 2ºGCIA
+--------------------------------------------------------*/
+
+#ifndef _JOBSPEC_H
+#define _JOBSPEC_H
+
+#include "job_control.h"
+
+// ----------- CONJUNTO DE TRABAJOS SELECCIONADOS -----------------------
+typedef struct job_set_
+{
+	job ** items;
+	int n, cap;
+	unsigned mark; /* marca de esta selección, evita repetir trabajos */
+} job_set;
+
+// -----------------------------------------------------------------------
+//      PUBLIC FUNCTIONS
+// -----------------------------------------------------------------------
+void jobset_init(job_set *set);
+void jobset_free(job_set *set);
+int jobspec_add(job *list, const char *spec, job_set *set);
+int jobspec_is_state(const char *name);
+int jobspec_add_state(job *list, const char *name, job_set *set);
+int jobspec_parse_signal(const char *name);
+int jobset_signal(job *list, job_set *set, int sig);
+
+#endif
@@ -0,0 +1,355 @@
+/*--------------------------------------------------------
+UNIX Shell Project
+jobtop module: consumo de recursos de cada trabajo de la lista
+
+Para cada trabajo se muestrea solo el líder del grupo (en trabajos con
+varios procesos, como las tuberías, el resto no cuenta): CPU% (utime+stime),
+RSS e hilos de /proc/<pid>/stat y bytes leídos/escritos por segundo
+(rchar/wchar) de /proc/<pid>/io. Antes se lee /proc/<pid>/schedstat, que
+es mucho más barato: si un proceso de un solo hilo no ha usado CPU desde
+la muestra anterior no hace falta leer los otros dos. Los ficheros se
+abren la primera vez y los fds se guardan en el trabajo (job->sample),
+de modo que cada refresco es un pread por fichero; delete_job los cierra
+con jobtop_forget. Si el trabajo relanza (respawnable) con otro pid se abren
+de nuevo. Los fds abiertos se limitan al RLIMIT_NOFILE disponible; por
+encima se abre y cierra en cada muestra. El shell sube su límite blando
+al duro para estos fds, pero los hijos se siguen lanzando con el original.
+
+Las tasas se calculan respecto a la muestra anterior de ese trabajo.
+
+Sistemas Operativos
+Grados I. Informatica, Computadores & Software
+Dept. Arquitectura de Computadores - UMA
+Iván Ballesteros Fernández - 24-25 - 2ºGCIA
+--------------------------------------------------------*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include "jobtop.h"
+
+#define FD_RESERVE 64 /* fds que se dejan libres para el shell y sus hijos */
+
+// ----------- FILA DE LA TABLA -----------------------------------------
+typedef struct row_
+{
+	pid_t pgid;
+	const char * state;
+	const char * command; /* del trabajo: válido mientras SIGCHLD está bloqueada */
+	int has_rates;        /* cpu, rd y wr tienen valor */
+	int has_io;           /* /proc/<pid>/io se pudo leer */
+	double cpu;           /* % de una CPU */
+	long rss_kb;
+	long threads;
+	double rd, wr;        /* bytes por segundo */
+} row;
+
+static int fd_budget = -1;  // fds que jobtop puede dejar abiertos
+static int fds_open = 0;
+static enum jobtop_col sort_col = COL_CPU;
+static long clk_tck, page_kb;
+
+static const char *col_names[] = { "pgid", "state", "cpu", "rss", "threads", "read", "write", "command" };
+static const char col_keys[] = "pecmtrwn"; // tecla de cada columna en modo interactivo
+
+// -----------------------------------------------------------------------
+/* sube el límite blando de fds al duro y reparte lo que queda */
+static void init_budget(void)
+{
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0) {
+        if (rl.rlim_cur < rl.rlim_max) {
+            launch_child_nofile(rl.rlim_cur); // la subida es solo para el shell
+            rl.rlim_cur = rl.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &rl);
+            getrlimit(RLIMIT_NOFILE, &rl);
+        }
+        fd_budget = (rl.rlim_cur > FD_RESERVE) ? (int) (rl.rlim_cur - FD_RESERVE) : 0;
+    } else {
+        fd_budget = 0;
+    }
+    clk_tck = sysconf(_SC_CLK_TCK);
+    page_kb = sysconf(_SC_PAGESIZE) / 1024;
+}
+
+static void close_fd(int *fd)
+{
+    if (*fd < 0) return;
+    close(*fd);
+    *fd = -1;
+    fds_open--;
+}
+
+/* lee /proc/<pid>/<file> desde el principio con el fd guardado en *fd
+   (abriéndolo si no lo está). devuelve los bytes leídos o -1 */
+static ssize_t proc_read(int *fd, pid_t pid, const char *file, char *buf, size_t size)
+{
+    int f = *fd;
+    if (f < 0) {
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/%d/%s", pid, file);
+        if ((f = open(path, O_RDONLY | O_CLOEXEC)) < 0) return -1;
+        if (fds_open < fd_budget) { // se queda abierto para la siguiente
+            *fd = f;
+            fds_open++;
+        }
+    }
+    ssize_t n = pread(f, buf, size - 1, 0);
+    if (f != *fd) close(f);
+    buf[n > 0 ? n : 0] = '\0';
+    return n;
+}
+
+/* salta n campos separados por espacios */
+static char * skip_fields(char *p, int n)
+{
+    while (n-- > 0 && p) {
+        p = strchr(p, ' ');
+        if (p) p++;
+    }
+    return p;
+}
+
+/* cierra los fds de /proc del trabajo (delete_job) */
+void jobtop_forget(job *item)
+{
+    if (item->sample == NULL) return;
+    close_fd(&item->sample->sched_fd);
+    close_fd(&item->sample->stat_fd);
+    close_fd(&item->sample->io_fd);
+    free(item->sample);
+    item->sample = NULL;
+}
+
+// -----------------------------------------------------------------------
+/* rellena r con una muestra nueva del trabajo. devuelve 0 o -1 si el
+   proceso ya no existe */
+static int sample_job(job *j, row *r, const struct timespec *now)
+{
+    char buf[1024];
+    char *p;
+    proc_sample *s = j->sample;
+
+    if (s == NULL) {
+        s = j->sample = (proc_sample *) calloc(1, sizeof(proc_sample));
+        s->sched_fd = s->stat_fd = s->io_fd = -1;
+    }
+    if (s->pid != j->pgid) { // trabajo nuevo o relanzado con otro pid
+        close_fd(&s->sched_fd);
+        close_fd(&s->stat_fd);
+        close_fd(&s->io_fd);
+        s->pid = j->pgid;
+        s->valid = 0;
+    }
+
+    double dt = (now->tv_sec - s->when.tv_sec) + (now->tv_nsec - s->when.tv_nsec) / 1e9;
+    r->has_rates = s->valid && dt > 0;
+
+    // schedstat (barato) dice si el proceso ha pasado por la CPU. Si tiene un
+    // solo hilo y no ha corrido, hilos, contadores de E/S y (salvo que el
+    // sistema le quite páginas) RSS siguen igual: no se leen stat ni io
+    unsigned long long run_ns = 0;
+    int have_sched = proc_read(&s->sched_fd, s->pid, "schedstat", buf, sizeof(buf)) > 0;
+    if (have_sched) run_ns = strtoull(buf, NULL, 10);
+    if (have_sched && s->valid && s->threads == 1 && run_ns == s->run_ns) {
+        r->threads = s->threads;
+        r->rss_kb = s->rss_kb;
+        r->has_io = s->has_io;
+        r->cpu = r->rd = r->wr = 0;
+        s->when = *now;
+        return 0;
+    }
+    s->run_ns = run_ns;
+
+    // campos de stat tras "pid (comm) ": 14 utime, 15 stime, 20 hilos, 24 rss
+    if (proc_read(&s->stat_fd, s->pid, "stat", buf, sizeof(buf)) <= 0) return -1;
+    p = strrchr(buf, ')');
+    if (p == NULL || (p = skip_fields(p + 2, 11)) == NULL) return -1;
+    unsigned long long utime = strtoull(p, &p, 10);
+    unsigned long long stime = strtoull(p, &p, 10);
+    if ((p = skip_fields(p + 1, 4)) == NULL) return -1;
+    r->threads = strtol(p, &p, 10);
+    if ((p = skip_fields(p + 1, 3)) == NULL) return -1;
+    r->rss_kb = strtol(p, NULL, 10) * page_kb;
+
+    // io: "rchar: N\nwchar: N\n..." (solo legible para procesos propios)
+    unsigned long long rchar = 0, wchar = 0;
+    r->has_io = 0;
+    if (proc_read(&s->io_fd, s->pid, "io", buf, sizeof(buf)) > 0 && strncmp(buf, "rchar: ", 7) == 0) {
+        rchar = strtoull(buf + 7, &p, 10);
+        if ((p = strstr(p, "wchar: ")) != NULL) {
+            wchar = strtoull(p + 7, NULL, 10);
+            r->has_io = 1;
+        }
+    }
+
+    unsigned long long ticks = utime + stime;
+    if (r->has_rates) {
+        r->cpu = 100.0 * (ticks - s->ticks) / clk_tck / dt;
+        r->rd = (rchar - s->rchar) / dt;
+        r->wr = (wchar - s->wchar) / dt;
+    }
+    s->ticks = ticks;
+    s->rchar = rchar;
+    s->wchar = wchar;
+    s->threads = r->threads;
+    s->has_io = r->has_io;
+    s->rss_kb = r->rss_kb;
+    s->when = *now;
+    s->valid = 1;
+    return 0;
+}
+
+// -----------------------------------------------------------------------
+static int cmp_row(const void *a, const void *b)
+{
+    const row *x = (const row *) a, *y = (const row *) b;
+    double d = 0;
+    switch (sort_col) {
+        case COL_PGID: return x->pgid - y->pgid;
+        case COL_STATE: d = -strcmp(x->state, y->state); break;
+        case COL_COMMAND: d = -strcmp(x->command, y->command); break;
+        case COL_CPU: d = (x->has_rates ? x->cpu : -1) - (y->has_rates ? y->cpu : -1); break;
+        case COL_RSS: d = x->rss_kb - y->rss_kb; break;
+        case COL_THREADS: d = x->threads - y->threads; break;
+        case COL_READ: d = (x->has_rates ? x->rd : -1) - (y->has_rates ? y->rd : -1); break;
+        case COL_WRITE: d = (x->has_rates ? x->wr : -1) - (y->has_rates ? y->wr : -1); break;
+    }
+    if (d != 0) return d > 0 ? -1 : 1; // de mayor a menor (texto: alfabético)
+    return x->pgid - y->pgid;
+}
+
+/* 1.2K, 3.4M... */
+static const char * human(double v, char *buf, size_t size)
+{
+    const char *units = "BKMGT";
+    int u = 0;
+    while (v >= 1024 && u < 4) {
+        v /= 1024;
+        u++;
+    }
+    if (u == 0) snprintf(buf, size, "%.0f%c", v, units[u]);
+    else snprintf(buf, size, "%.1f%c", v, units[u]);
+    return buf;
+}
+
+int jobtop_parse_col(const char *name)
+{
+    for (int i = 0; i <= COL_COMMAND; i++) {
+        if (strcmp(name, col_names[i]) == 0 || (name[1] == '\0' && name[0] == col_keys[i])) return i;
+    }
+    return -1;
+}
+
+// -----------------------------------------------------------------------
+static void render(FILE *out, row *rows, int n, int shown, double sample_ms, int interactive)
+{
+    char b1[16], b2[16], b3[16];
+    if (interactive) fputs("\033[H\033[2J", out);
+    fprintf(out, "jobtop: %d trabajos (líder de cada grupo), muestreo %.2f ms, orden: %s", n, sample_ms, col_names[sort_col]);
+    fputs(interactive ? "  (q salir; p e c m t r w n ordenar)\n" : "\n", out);
+    fprintf(out, "%8s %-11s %6s %8s %4s %9s %9s  %s\n",
+            "PGID", "STATE", "CPU%", "RSS", "THR", "READ/s", "WRITE/s", "COMMAND");
+    for (int i = 0; i < shown; i++) {
+        row *r = &rows[i];
+        char cpu[16];
+        if (r->has_rates) snprintf(cpu, sizeof(cpu), "%.1f", r->cpu);
+        else strcpy(cpu, "-");
+        fprintf(out, "%8d %-11s %6s %8s %4ld %9s %9s  %s\n", r->pgid, r->state, cpu,
+                human(r->rss_kb * 1024.0, b1, sizeof(b1)), r->threads,
+                r->has_rates && r->has_io ? human(r->rd, b2, sizeof(b2)) : "-",
+                r->has_rates && r->has_io ? human(r->wr, b3, sizeof(b3)) : "-",
+                r->command);
+    }
+    if (shown < n) fprintf(out, "... %d más\n", n - shown);
+}
+
+/* muestra la tabla cada interval segundos. iterations > 0: ese número de
+   refrescos seguidos sin borrar la pantalla; 0: hasta pulsar q (o uno
+   solo si la entrada no es un terminal y no hay tecla que lo pare) */
+void jobtop(job *list, double interval, int iterations, enum jobtop_col sort)
+{
+    int interactive = (iterations == 0 && isatty(STDIN_FILENO));
+    if (iterations == 0 && !interactive) iterations = 1;
+    struct termios saved, raw;
+    row *rows = NULL;
+    int cap = 0;
+
+    if (fd_budget < 0) init_budget();
+    sort_col = sort;
+    if (interactive) { // sin eco ni modo línea para leer las teclas una a una
+        tcgetattr(STDIN_FILENO, &saved);
+        raw = saved;
+        raw.c_lflag &= ~(ICANON | ECHO | ISIG);
+        raw.c_cc[VMIN] = 1;
+        raw.c_cc[VTIME] = 0;
+        tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+    }
+
+    for (int it = 0; iterations == 0 || it < iterations; it++) {
+        struct timespec now, end;
+        int n = 0, shown;
+
+        // la lista no puede cambiar mientras se recorre y se imprime
+        block_SIGCHLD();
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (cap < list_size(list)) {
+            cap = list_size(list) * 2;
+            rows = (row *) realloc(rows, cap * sizeof(row));
+        }
+        for (job *j = list->next; j && n < cap; j = j->next) {
+            rows[n].pgid = j->pgid;
+            rows[n].state = state_strings[j->state];
+            rows[n].command = j->command;
+            if (sample_job(j, &rows[n], &now) == 0) n++;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        qsort(rows, n, sizeof(row), cmp_row);
+
+        shown = n;
+        if (interactive) {
+            struct winsize ws;
+            int lines = (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_row > 4) ? ws.ws_row - 3 : 20;
+            if (shown > lines) shown = lines;
+        }
+        char *frame;
+        size_t frame_len;
+        FILE *out = open_memstream(&frame, &frame_len); // un único write por refresco
+        render(out, rows, n, shown,
+               (end.tv_sec - now.tv_sec) * 1e3 + (end.tv_nsec - now.tv_nsec) / 1e6, interactive);
+        if (!interactive && it + 1 < iterations) fputc('\n', out);
+        fclose(out);
+        fflush(stdout);
+        if (write(STDOUT_FILENO, frame, frame_len) < 0) { /* nada que hacer */ }
+        free(frame);
+        unblock_SIGCHLD();
+
+        if (!interactive) {
+            if (it + 1 < iterations) {
+                struct timespec ts = { (time_t) interval, (long) ((interval - (time_t) interval) * 1e9) };
+                while (nanosleep(&ts, &ts) == -1 && errno == EINTR);
+            }
+            continue;
+        }
+
+        // espera el intervalo o una tecla
+        struct pollfd pfd = { STDIN_FILENO, POLLIN, 0 };
+        int quit = 0;
+        if (poll(&pfd, 1, (int) (interval * 1000)) > 0) {
+            char key;
+            if (read(STDIN_FILENO, &key, 1) != 1 || key == 'q' || key == 3 || key == 4) quit = 1;
+            const char *k = strchr(col_keys, key);
+            if (k && key) sort_col = k - col_keys;
+        }
+        if (quit) break;
+    }
+
+    if (interactive) tcsetattr(STDIN_FILENO, TCSANOW, &saved);
+    free(rows);
+}
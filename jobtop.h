@@ -0,0 +1,27 @@
+/*--------------------------------------------------------
+UNIX Shell Project
+function prototypes for jobtop module: consumo de recursos de cada
+trabajo de la lista, refrescado como top
+
+Sistemas Operativos
+Grados I. Informatica, Computadores & Software
+Dept. Arquitectura de Computadores - UMA
+Iván Ballesteros Fernández - 24-25 - 2ºGCIA
+--------------------------------------------------------*/
+
+#ifndef _JOBTOP_H
+#define _JOBTOP_H
+
+#include "job_control.h"
+
+// columnas por las que se puede ordenar
+enum jobtop_col { COL_PGID, COL_STATE, COL_CPU, COL_RSS, COL_THREADS, COL_READ, COL_WRITE, COL_COMMAND };
+
+// -----------------------------------------------------------------------
+//      PUBLIC FUNCTIONS
+// -----------------------------------------------------------------------
+void jobtop(job *list, double interval, int iterations, enum jobtop_col sort);
+int jobtop_parse_col(const char *name);
+void jobtop_forget(job *item);
+
+#endif
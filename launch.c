@@ -0,0 +1,493 @@
+/*--------------------------------------------------------
+UNIX Shell Project
+launch module: prioridad, clase de planificación, ioprio y límites de
+recursos de los trabajos
+
+Sistemas Operativos
+Grados I. Informatica, Computadores & Software
+Dept. Arquitectura de Computadores - UMA
+Iván Ballesteros Fernández - 24-25 - 2ºGCIA
+--------------------------------------------------------*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include "job_control.h"
+#include "zygote.h"
+#include "vars.h"
+
+static const char *policy_names[] = { "other", "fifo", "rr", "batch", "", "idle" };
+static const char *io_names[] = { "none", "rt", "be", "idle" };
+
+// recursos de ulimit, en el orden de enum launch_limit
+static const struct { const char *name; int resource; int is_size; } limit_defs[LIMIT_COUNT] = {
+    { "cpu", RLIMIT_CPU, 0 }, { "as", RLIMIT_AS, 1 }, { "nofile", RLIMIT_NOFILE, 0 },
+    { "nproc", RLIMIT_NPROC, 0 }, { "core", RLIMIT_CORE, 1 },
+};
+
+// perfiles de ulimit con nombre (solo se usan sus límites)
+static struct { char name[LIMIT_PROFILE_NAME]; launch_opts opts; } profiles[MAX_LIMIT_PROFILES];
+static int nprofiles = 0;
+
+// -----------------------------------------------------------------------
+/* deja todas las opciones a "heredar del shell" */
+void init_launch_opts(launch_opts *opts)
+{
+    opts->nice = LAUNCH_INHERIT;
+    opts->policy = LAUNCH_INHERIT;
+    opts->io_class = LAUNCH_INHERIT;
+    opts->io_level = 0;
+    sigemptyset(&opts->mask);
+    opts->limits_set = 0;
+}
+
+// -----------------------------------------------------------------------
+/* copia en dst solo las opciones que se han indicado en src */
+void merge_launch_opts(launch_opts *dst, const launch_opts *src)
+{
+    if (src->nice != LAUNCH_INHERIT) dst->nice = src->nice;
+    if (src->policy != LAUNCH_INHERIT) dst->policy = src->policy;
+    if (src->io_class != LAUNCH_INHERIT) {
+        dst->io_class = src->io_class;
+        dst->io_level = src->io_level;
+    }
+    sigorset(&dst->mask, &dst->mask, &src->mask);
+    for (int i = 0; i < LIMIT_COUNT; i++) {
+        if (src->limits_set & (1u << i)) dst->limits[i] = src->limits[i];
+    }
+    dst->limits_set |= src->limits_set;
+}
+
+// -----------------------------------------------------------------------
+/* 1 si no se ha indicado ninguna opción */
+int launch_opts_empty(const launch_opts *opts)
+{
+    return opts->nice == LAUNCH_INHERIT && opts->policy == LAUNCH_INHERIT &&
+           opts->io_class == LAUNCH_INHERIT && sigisemptyset(&opts->mask) && opts->limits_set == 0;
+}
+
+// -----------------------------------------------------------------------
+/* interpreta la opción que hay en args[*i]:
+   -n <nice>   -p other|batch|idle   -io rt|be|idle[:nivel]
+   devuelve 1 si la ha consumido (avanzando *i), 0 si no es una opción
+   de lanzamiento y -1 si es una opción mal formada */
+int parse_launch_opt(char **args, int *i, launch_opts *opts)
+{
+    char *opt = args[*i];
+    char *val = args[*i + 1];
+    char *end;
+
+    if (strcmp(opt, "-n") && strcmp(opt, "-p") && strcmp(opt, "-io")) return 0;
+    if (val == NULL) return -1;
+
+    if (strcmp(opt, "-n") == 0) {
+        long n = strtol(val, &end, 10);
+        if (*end || n < -20 || n > 19) return -1;
+        opts->nice = (int) n;
+    } else if (strcmp(opt, "-p") == 0) {
+        if (strcmp(val, "other") == 0) opts->policy = SCHED_OTHER;
+        else if (strcmp(val, "batch") == 0) opts->policy = SCHED_BATCH;
+        else if (strcmp(val, "idle") == 0) opts->policy = SCHED_IDLE;
+        else return -1;
+    } else {
+        int level = 4; // nivel por defecto de la clase best-effort
+        char *colon = strchr(val, ':');
+        if (colon) {
+            level = (int) strtol(colon + 1, &end, 10);
+            if (*end || level < 0 || level > 7) return -1;
+        }
+        int len = colon ? (int)(colon - val) : (int) strlen(val);
+        if (len == 2 && strncmp(val, "rt", 2) == 0) opts->io_class = IOPRIO_RT;
+        else if (len == 2 && strncmp(val, "be", 2) == 0) opts->io_class = IOPRIO_BE;
+        else if (len == 4 && strncmp(val, "idle", 4) == 0) { opts->io_class = IOPRIO_IDLE; level = 0; }
+        else return -1;
+        opts->io_level = level;
+    }
+    *i += 2;
+    return 1;
+}
+
+// -----------------------------------------------------------------------
+/* se llama en el hijo justo antes de exec; los fallos se avisan
+   pero no impiden lanzar el comando */
+void apply_launch_opts(const launch_opts *opts)
+{
+    if (opts->policy != LAUNCH_INHERIT) {
+        struct sched_param param = { .sched_priority = 0 };
+        if (sched_setscheduler(0, opts->policy, &param) == -1)
+            perror("sched_setscheduler");
+    }
+    if (opts->nice != LAUNCH_INHERIT) {
+        if (setpriority(PRIO_PROCESS, 0, opts->nice) == -1)
+            perror("setpriority");
+    }
+    if (opts->io_class != LAUNCH_INHERIT) {
+        if (syscall(SYS_ioprio_set, IOPRIO_PROCESS, 0,
+                    IOPRIO_VALUE(opts->io_class, opts->io_level)) == -1)
+            perror("ioprio_set");
+    }
+    for (int i = 0; i < LIMIT_COUNT; i++) {
+        if (!(opts->limits_set & (1u << i))) continue;
+        struct rlimit rl = { opts->limits[i], opts->limits[i] };
+        // con el límite duro igual al blando el kernel mata con SIGKILL sin
+        // mandar antes SIGXCPU: se deja un segundo de margen
+        if (i == LIMIT_CPU && rl.rlim_max != RLIM_INFINITY) rl.rlim_max++;
+        if (setrlimit(limit_defs[i].resource, &rl) == -1)
+            fprintf(stderr, "setrlimit %s: %s\n", limit_defs[i].name, strerror(errno));
+    }
+    sigprocmask(SIG_BLOCK, &opts->mask, NULL);
+}
+
+// -----------------------------------------------------------------------
+/* interpreta un límite recurso=valor (cpu en segundos, as y core en bytes
+   con sufijo K, M o G opcional, nofile y nproc en unidades; "unlimited"
+   para quitarlo). devuelve 1 si lo ha guardado en opts, 0 si arg no tiene
+   esa forma y -1 si el recurso o el valor no son válidos */
+int parse_limit_opt(const char *arg, launch_opts *opts)
+{
+    const char *eq = strchr(arg, '=');
+    char *end;
+    if (eq == NULL || eq == arg) return 0;
+
+    for (int i = 0; i < LIMIT_COUNT; i++) {
+        if (strlen(limit_defs[i].name) != (size_t)(eq - arg) || strncmp(arg, limit_defs[i].name, eq - arg)) continue;
+        rlim_t value;
+        if (strcmp(eq + 1, "unlimited") == 0) {
+            value = RLIM_INFINITY;
+        } else {
+            if (eq[1] < '0' || eq[1] > '9') return -1;
+            unsigned long long v = strtoull(eq + 1, &end, 10);
+            if (limit_defs[i].is_size && *end) {
+                switch (*end++) {
+                    case 'K': case 'k': v <<= 10; break;
+                    case 'M': case 'm': v <<= 20; break;
+                    case 'G': case 'g': v <<= 30; break;
+                    default: return -1;
+                }
+            }
+            if (*end) return -1;
+            value = (rlim_t) v;
+        }
+        opts->limits[i] = value;
+        opts->limits_set |= 1u << i;
+        return 1;
+    }
+    return -1;
+}
+
+// -----------------------------------------------------------------------
+/* escribe en buf los límites indicados en opts ("cpu=10 as=512M ...") */
+void format_limits(const launch_opts *opts, char *buf, int size)
+{
+    int len = 0;
+    buf[0] = '\0';
+    for (int i = 0; i < LIMIT_COUNT && len < size; i++) {
+        if (!(opts->limits_set & (1u << i))) continue;
+        rlim_t v = opts->limits[i];
+        const char *sep = len ? " " : "";
+        if (v == RLIM_INFINITY)
+            len += snprintf(buf + len, size - len, "%s%s=unlimited", sep, limit_defs[i].name);
+        else if (limit_defs[i].is_size && v && v % (1 << 20) == 0)
+            len += snprintf(buf + len, size - len, "%s%s=%lluM", sep, limit_defs[i].name, (unsigned long long)(v >> 20));
+        else
+            len += snprintf(buf + len, size - len, "%s%s=%llu", sep, limit_defs[i].name, (unsigned long long) v);
+    }
+}
+
+// -----------------------------------------------------------------------
+/* guarda (o reemplaza) el perfil name con los límites de opts.
+   devuelve 0 o -1 si el nombre es demasiado largo o no caben más perfiles */
+int limit_profile_define(const char *name, const launch_opts *opts)
+{
+    int i;
+    if (strlen(name) >= LIMIT_PROFILE_NAME) return -1;
+    for (i = 0; i < nprofiles && strcmp(profiles[i].name, name); i++);
+    if (i == nprofiles) {
+        if (nprofiles == MAX_LIMIT_PROFILES) return -1;
+        strcpy(profiles[nprofiles++].name, name);
+    }
+    init_launch_opts(&profiles[i].opts); // un perfil solo guarda límites
+    profiles[i].opts.limits_set = opts->limits_set;
+    memcpy(profiles[i].opts.limits, opts->limits, sizeof(opts->limits));
+    return 0;
+}
+
+/* añade a opts los límites del perfil name; -1 si no existe */
+int limit_profile_apply(const char *name, launch_opts *opts)
+{
+    for (int i = 0; i < nprofiles; i++) {
+        if (strcmp(profiles[i].name, name) == 0) {
+            merge_launch_opts(opts, &profiles[i].opts);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+void limit_profiles_print(void)
+{
+    char buf[256];
+    if (nprofiles == 0) printf("No hay perfiles de límites definidos.\n");
+    for (int i = 0; i < nprofiles; i++) {
+        format_limits(&profiles[i].opts, buf, sizeof(buf));
+        printf(" %s: %s\n", profiles[i].name, buf);
+    }
+}
+
+// -----------------------------------------------------------------------
+/* cambia las opciones de todo un grupo de procesos ya lanzado.
+   nice e ioprio tienen variante por grupo; la clase de planificación es
+   por hilo, así que se recorren las tareas de /proc que pertenecen al grupo.
+   devuelve 0 si todo fue bien, -1 si falló alguna llamada */
+int renice_group(pid_t pgid, const launch_opts *opts)
+{
+    int res = 0;
+
+    if (opts->nice != LAUNCH_INHERIT && setpriority(PRIO_PGRP, pgid, opts->nice) == -1) {
+        perror("setpriority");
+        res = -1;
+    }
+    if (opts->io_class != LAUNCH_INHERIT &&
+        syscall(SYS_ioprio_set, IOPRIO_PGRP, pgid, IOPRIO_VALUE(opts->io_class, opts->io_level)) == -1) {
+        perror("ioprio_set");
+        res = -1;
+    }
+    if (opts->policy == LAUNCH_INHERIT) return res;
+
+    DIR *proc = opendir("/proc");
+    if (proc == NULL) return -1;
+    struct dirent *ent;
+    struct sched_param param = { .sched_priority = 0 };
+    while ((ent = readdir(proc)) != NULL) {
+        pid_t pid = atoi(ent->d_name);
+        if (pid <= 0 || getpgid(pid) != pgid) continue;
+
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/%d/task", pid);
+        DIR *tasks = opendir(path);
+        if (tasks == NULL) continue; // el proceso ha terminado entre medias
+        struct dirent *t;
+        while ((t = readdir(tasks)) != NULL) {
+            pid_t tid = atoi(t->d_name);
+            if (tid > 0 && sched_setscheduler(tid, opts->policy, &param) == -1 && errno != ESRCH) {
+                perror("sched_setscheduler");
+                res = -1;
+            }
+        }
+        closedir(tasks);
+    }
+    closedir(proc);
+    return res;
+}
+
+// -----------------------------------------------------------------------
+/* escribe en buf los valores efectivos (consultados al kernel) del proceso */
+void format_launch_opts(pid_t pid, char *buf, int size)
+{
+    errno = 0;
+    int nice = getpriority(PRIO_PROCESS, pid);
+    int policy = sched_getscheduler(pid);
+    long io = syscall(SYS_ioprio_get, IOPRIO_PROCESS, pid);
+
+    if (errno || policy < 0 || io < 0) {
+        snprintf(buf, size, "nice: -, sched: -, io: -");
+        return;
+    }
+    policy &= ~SCHED_RESET_ON_FORK;
+    snprintf(buf, size, "nice: %d, sched: %s, io: %s/%ld", nice,
+             (policy >= 0 && policy <= SCHED_IDLE) ? policy_names[policy] : "?",
+             io_names[IOPRIO_CLASS(io) & 3], IOPRIO_LEVEL(io));
+}
+
+// -----------------------------------------------------------------------
+/* abre el descriptor que corresponde a una redirección de fichero o
+   here-string. el texto del here-string va a un memfd, no a un temporal */
+static int open_redir_target(const redir_op *op)
+{
+    switch (op->type) {
+        case REDIR_IN:     return open(op->path, O_RDONLY);
+        case REDIR_OUT:    return open(op->path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+        case REDIR_APPEND: return open(op->path, O_WRONLY | O_CREAT | O_APPEND, 0666);
+        case REDIR_HERESTR: {
+            int fd = memfd_create("herestring", MFD_CLOEXEC);
+            size_t len = strlen(op->path);
+            if (fd < 0) return -1;
+            if (write(fd, op->path, len) != (ssize_t) len || write(fd, "\n", 1) != 1 ||
+                lseek(fd, 0, SEEK_SET) == -1) {
+                close(fd);
+                return -1;
+            }
+            return fd;
+        }
+        default: return -1;
+    }
+}
+
+// -----------------------------------------------------------------------
+/* aplica las redirecciones en orden sobre los descriptores del proceso
+   (se llama en el hijo). devuelve -1 si falla algo, tras informar del error */
+int apply_redirections(const redir_list *redirs)
+{
+    for (int i = 0; redirs && i < redirs->n; i++) {
+        const redir_op *op = &redirs->ops[i];
+        if (op->type == REDIR_DUP) {
+            if (dup2(op->target, op->fd) < 0) {
+                perror("Error en dup2 de la redirección");
+                return -1;
+            }
+            continue;
+        }
+        int fd = open_redir_target(op);
+        if (fd < 0) {
+            fprintf(stderr, "Error abriendo %s: %s\n", op->type == REDIR_HERESTR ? "here-string" : op->path, strerror(errno));
+            return -1;
+        }
+        if (fd != op->fd) {
+            if (dup2(fd, op->fd) < 0) {
+                perror("Error en dup2 de la redirección");
+                close(fd);
+                return -1;
+            }
+            close(fd); // ya no necesitamos el descriptor original
+        } else {
+            fcntl(fd, F_SETFD, 0); // el memfd se abrió con CLOEXEC
+        }
+    }
+    return 0;
+}
+
+// -----------------------------------------------------------------------
+/* versión para comandos que se ejecutan dentro del shell: en lugar de
+   tocar los descriptores del shell deja en fds[0..2] los que debe usar el
+   comando. devuelve -1 si falla algo o si se redirige un descriptor > 2 */
+int open_redirections(const redir_list *redirs, int fds[3])
+{
+    int owned[3] = { 0, 0, 0 }; // fds[i] lo hemos abierto nosotros
+
+    for (int i = 0; i < 3; i++) fds[i] = i;
+    for (int i = 0; redirs && i < redirs->n; i++) {
+        const redir_op *op = &redirs->ops[i];
+        if (op->fd > 2 || (op->type == REDIR_DUP && op->target > 2)) {
+            errno = EBADF;
+            goto error;
+        }
+        int fd = (op->type == REDIR_DUP) ? dup(fds[op->target]) : open_redir_target(op);
+        if (fd < 0) {
+            fprintf(stderr, "Error abriendo %s: %s\n", op->path ? op->path : "descriptor", strerror(errno));
+            goto error;
+        }
+        if (owned[op->fd]) close(fds[op->fd]);
+        fds[op->fd] = fd;
+        owned[op->fd] = 1;
+    }
+    return 0;
+
+error:
+    for (int i = 0; i < 3; i++) if (owned[i]) close(fds[i]);
+    return -1;
+}
+
+/* cierra los descriptores que abrió open_redirections */
+void close_redirections(int fds[3])
+{
+    for (int i = 0; i < 3; i++) if (fds[i] != i) close(fds[i]);
+}
+
+// -----------------------------------------------------------------------
+/* copia profunda (para guardar la lista más allá de la línea actual) */
+void copy_redirections(redir_list *dst, const redir_list *src)
+{
+    *dst = *src;
+    for (int i = 0; i < dst->n; i++) {
+        if (dst->ops[i].path) dst->ops[i].path = strdup(dst->ops[i].path);
+    }
+}
+
+void free_redirections(redir_list *redirs)
+{
+    for (int i = 0; i < redirs->n; i++) free(redirs->ops[i].path);
+    redirs->n = 0;
+}
+
+// -----------------------------------------------------------------------
+static rlim_t child_nofile; // límite blando de fds que deben recibir los hijos
+static int child_nofile_set = 0;
+
+/* el shell ha subido su límite blando de fds para uso propio (jobtop):
+   los hijos se lanzan con el valor original */
+void launch_child_nofile(rlim_t soft)
+{
+    child_nofile = soft;
+    child_nofile_set = 1;
+}
+
+/* en un proceso recién creado a partir del shell (hijo o lanzador zygote):
+   vuelve al límite blando de fds original */
+void restore_child_nofile(void)
+{
+    struct rlimit rl;
+    if (child_nofile_set && getrlimit(RLIMIT_NOFILE, &rl) == 0) {
+        rl.rlim_cur = child_nofile;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+}
+
+/* prepara el hijo (señales, grupo, opciones y redirecciones) y ejecuta
+   argv. no retorna: si exec falla sale con el código que usa bash, con
+   _exit para no volcar otra vez lo que el shell tenía pendiente en stdout */
+void exec_child(char **argv, const launch_opts *opts, const redir_list *redirs)
+{
+    sigset_t empty;
+    restore_terminal_signals(); /* Restaurar señales por defecto */
+    sigemptyset(&empty);        /* El padre puede tener SIGCHLD y otras bloqueadas: */
+    sigprocmask(SIG_SETMASK, &empty, NULL); /* la máscara del hijo es solo la de mask */
+    new_process_group(0);       /* Crear un nuevo grupo de procesos */
+    restore_child_nofile(); // antes que los límites de ulimit, que mandan
+    if (opts) apply_launch_opts(opts);
+    if (apply_redirections(redirs) == -1) _exit(1);
+
+    execvp(argv[0], argv); /* Intentar ejecutar el comando */
+
+    // Manejo de errores si execvp falla
+    switch (errno) {
+        case ENOENT: /* Archivo no encontrado */
+            fprintf(stderr, "error: command not found: %s\n", argv[0]);
+            _exit(127);
+        case EACCES: /* Permisos insuficientes */
+            fprintf(stderr, "error: permission denied: %s\n", argv[0]);
+            _exit(126);
+        case ENOEXEC: /* No es un ejecutable válido */
+            fprintf(stderr, "error: not an executable: %s\n", argv[0]);
+            _exit(126);
+        default: /* Otros errores */
+            fprintf(stderr, "error: execvp failed (%s): %s\n", strerror(errno), argv[0]);
+            _exit(EXIT_FAILURE);
+    }
+}
+
+// -----------------------------------------------------------------------
+/* lanza argv en su propio grupo de procesos con las opciones indicadas
+   (opts puede ser NULL). si el lanzador (zygote) está activo se le pide a
+   él, si no se hace fork desde el shell. devuelve el pid o -1.
+   el llamante debe tener SIGCHLD bloqueada hasta añadir el trabajo a la lista */
+pid_t spawn_job(char **argv, const launch_opts *opts, const redir_list *redirs)
+{
+    pid_t pid;
+    vars_envp(); // publica en environ el entorno actual (solo se reconstruye si ha cambiado)
+    if (zygote_running() && (pid = zygote_spawn(argv, opts, redirs)) > 0) {
+        new_process_group(pid);
+        return pid;
+    }
+    pid = fork();
+    if (pid == 0) exec_child(argv, opts, redirs);
+    if (pid > 0) new_process_group(pid); // también en el padre para evitar la carrera con el hijo
+    return pid;
+}
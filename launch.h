@@ -0,0 +1,90 @@
+/*--------------------------------------------------------
+UNIX Shell Project
+function prototypes and type declarations for launch module:
+opciones de lanzamiento que se aplican en el hijo antes de exec
+
+Sistemas Operativos
+Grados I. Informatica, Computadores & Software
+Dept. Arquitectura de Computadores - UMA
+Iván Ballesteros Fernández - 24-25 - 2ºGCIA
+--------------------------------------------------------*/
+
+#ifndef _LAUNCH_H
+#define _LAUNCH_H
+
+#include <sys/types.h>
+#include <sys/resource.h>
+#include <signal.h>
+
+// ----------- CONSTANTES PARA IOPRIO (no expuestas por glibc) ----------
+#define IOPRIO_CLASS_SHIFT  13
+#define IOPRIO_PRIO_MASK    ((1UL << IOPRIO_CLASS_SHIFT) - 1)
+#define IOPRIO_VALUE(cls, lvl) (((cls) << IOPRIO_CLASS_SHIFT) | (lvl))
+#define IOPRIO_CLASS(val)   ((val) >> IOPRIO_CLASS_SHIFT)
+#define IOPRIO_LEVEL(val)   ((val) & IOPRIO_PRIO_MASK)
+enum ioprio_class { IOPRIO_NONE, IOPRIO_RT, IOPRIO_BE, IOPRIO_IDLE };
+enum ioprio_who { IOPRIO_PROCESS = 1, IOPRIO_PGRP = 2 };
+
+#define LAUNCH_INHERIT (-100) // valor por defecto: se hereda del shell
+
+// ----------- LÍMITES DE RECURSOS (ulimit) ------------------------------
+enum launch_limit { LIMIT_CPU, LIMIT_AS, LIMIT_NOFILE, LIMIT_NPROC, LIMIT_CORE, LIMIT_COUNT };
+#define MAX_LIMIT_PROFILES 16 /* perfiles de ulimit con nombre */
+#define LIMIT_PROFILE_NAME 32 /* longitud máxima del nombre de un perfil */
+
+// ----------- OPCIONES DE LANZAMIENTO ----------------------------------
+typedef struct launch_opts_
+{
+	int nice;      /* nivel nice absoluto, LAUNCH_INHERIT si no se indica */
+	int policy;    /* SCHED_OTHER, SCHED_BATCH o SCHED_IDLE */
+	int io_class;  /* enum ioprio_class */
+	int io_level;  /* 0 (mayor prioridad) .. 7 */
+	sigset_t mask; /* señales a bloquear en el hijo (mask) */
+	unsigned limits_set;             /* bit i: se fija limits[i] */
+	rlim_t limits[LIMIT_COUNT];      /* valor de cada límite (ulimit) */
+} launch_opts;
+
+// ----------- REDIRECCIONES (parse_redirections) ----------------------
+#define MAX_REDIRS 16 /* redirecciones máximas por comando */
+enum redir_type { REDIR_IN, REDIR_OUT, REDIR_APPEND, REDIR_DUP, REDIR_HERESTR };
+
+typedef struct redir_op_
+{
+	enum redir_type type;
+	int fd;       /* descriptor que se redirige */
+	int target;   /* REDIR_DUP: descriptor que se duplica sobre fd */
+	char * path;  /* fichero, o texto del here-string */
+} redir_op;
+
+typedef struct redir_list_
+{
+	int n;
+	redir_op ops[MAX_REDIRS]; /* se aplican en orden */
+} redir_list;
+
+// -----------------------------------------------------------------------
+//      PUBLIC FUNCTIONS
+// -----------------------------------------------------------------------
+void init_launch_opts(launch_opts *opts);
+int parse_launch_opt(char **args, int *i, launch_opts *opts);
+void apply_launch_opts(const launch_opts *opts);
+int renice_group(pid_t pgid, const launch_opts *opts);
+int launch_opts_empty(const launch_opts *opts);
+void merge_launch_opts(launch_opts *dst, const launch_opts *src);
+void format_launch_opts(pid_t pid, char *buf, int size);
+int parse_limit_opt(const char *arg, launch_opts *opts);
+void format_limits(const launch_opts *opts, char *buf, int size);
+int limit_profile_define(const char *name, const launch_opts *opts);
+int limit_profile_apply(const char *name, launch_opts *opts);
+void limit_profiles_print(void);
+int apply_redirections(const redir_list *redirs);
+int open_redirections(const redir_list *redirs, int fds[3]);
+void close_redirections(int fds[3]);
+void copy_redirections(redir_list *dst, const redir_list *src);
+void free_redirections(redir_list *redirs);
+void launch_child_nofile(rlim_t soft);
+void restore_child_nofile(void);
+void exec_child(char **argv, const launch_opts *opts, const redir_list *redirs);
+pid_t spawn_job(char **argv, const launch_opts *opts, const redir_list *redirs);
+
+#endif
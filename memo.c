@@ -0,0 +1,588 @@
+/*--------------------------------------------------------
+UNIX Shell Project
+memo module: caché en disco de la salida de comandos deterministas
+
+memo calcula una clave con los argumentos, el directorio actual, las
+variables indicadas con -e, las redirecciones y la huella (dispositivo,
+inodo, tamaño y mtime, o el contenido con -H) de los ficheros de entrada
+(<) y de los indicados con -d. Si la clave está en la caché se reproduce
+la salida estándar, los ficheros de salida (>) y el estado sin crear
+ningún proceso; si no, se ejecuta el comando en primer plano con la
+salida por una tubería que un proceso auxiliar copia a la vez a la
+pantalla y a un memfd (como tee), y se guarda el resultado. Si el
+comando se suspende con ctrl+z pasa a la lista de trabajos como
+cualquier otro y no se guarda.
+
+Cada entrada es un directorio <caché>/<clave> con:
+  meta    estado de salida y duración de la ejecución original
+  out     salida estándar (y lo que se redirigió a ella)
+  r<i>    contenido final del fichero de la redirección i
+La caché vive en $MEMO_DIR, $XDG_CACHE_HOME/shell-memo o
+~/.cache/shell-memo y la comparten todos los shells. El mtime del
+directorio marca el último uso: al guardar, si se pasa del tamaño máximo
+se borran las entradas usadas hace más tiempo (LRU).
+
+Sistemas Operativos
+Grados I. Informatica, Computadores & Software
+Dept. Arquitectura de Computadores - UMA
+Iván Ballesteros Fernández - 24-25 - 2ºGCIA
+--------------------------------------------------------*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "memo.h"
+#include "job_control.h"
+#include "fastcmd.h"
+#include "vars.h"
+
+// clave de 128 bits: dos pasadas independientes sobre los mismos datos
+typedef struct {
+    unsigned long long a, b;
+} memo_hash;
+
+// entrada de la caché vista al recorrer el directorio
+typedef struct {
+    char name[40];
+    struct timespec used;
+    unsigned long long size;
+} memo_entry;
+
+static unsigned long long limit = MEMO_CACHE_SIZE;
+static unsigned long hits = 0, misses = 0, stores = 0, evictions = 0;
+static long long saved_ns = 0; // tiempo de ejecución ahorrado por los aciertos
+static pid_t tees[16];          // copias de la salida que siguen vivas (las recoge sigchld_handler)
+static int ntees = 0;
+
+// -----------------------------------------------------------------------
+static void feed(memo_hash *h, const void *data, size_t len)
+{
+    const unsigned char *p = (const unsigned char *) data;
+    for (size_t i = 0; i < len; i++) {
+        h->a = (h->a ^ p[i]) * 1099511628211ULL; // FNV-1a de 64 bits
+        h->b = (h->b + p[i]) * 0x9E3779B97F4A7C15ULL;
+        h->b ^= h->b >> 29;
+    }
+}
+
+static void feed_str(memo_hash *h, const char *s)
+{
+    feed(h, s, strlen(s) + 1); // con el '\0': "ab" "c" no es "a" "bc"
+}
+
+/* huella de un fichero: por contenido o por identidad y mtime */
+static void fingerprint(memo_hash *h, const char *path, int content)
+{
+    struct stat st;
+    feed_str(h, path);
+    if (stat(path, &st) == -1) {
+        feed_str(h, "\001missing");
+        return;
+    }
+    feed(h, &st.st_size, sizeof(st.st_size));
+    if (content && S_ISREG(st.st_mode)) {
+        int fd = open(path, O_RDONLY);
+        void *map = (fd >= 0 && st.st_size > 0) ? mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+        if (map != MAP_FAILED) {
+            madvise(map, st.st_size, MADV_SEQUENTIAL);
+            feed(h, map, st.st_size);
+            munmap(map, st.st_size);
+        }
+        if (fd >= 0) close(fd);
+        return;
+    }
+    feed(h, &st.st_dev, sizeof(st.st_dev));
+    feed(h, &st.st_ino, sizeof(st.st_ino));
+    feed(h, &st.st_mtim, sizeof(st.st_mtim));
+}
+
+/* clave de la ejecución en hex (33 bytes) */
+static void make_key(char **argv, const memo_opts *m, const redir_list *redirs, char *key)
+{
+    memo_hash h = { 14695981039346656037ULL, 0x6A09E667F3BCC908ULL };
+    char cwd[4096];
+
+    feed_str(&h, "memo1");
+    for (int i = 0; argv[i]; i++) feed_str(&h, argv[i]);
+    feed_str(&h, getcwd(cwd, sizeof(cwd)) ? cwd : "");
+    for (int i = 0; i < m->nenv; i++) {
+        const char *val = var_get(m->env[i]);
+        feed_str(&h, m->env[i]);
+        feed_str(&h, val ? val : "\001unset");
+    }
+    for (int i = 0; i < redirs->n; i++) {
+        const redir_op *op = &redirs->ops[i];
+        int num[3] = { op->type, op->fd, op->target };
+        feed(&h, num, sizeof(num));
+        if (op->path == NULL) continue;
+        if (op->type == REDIR_IN) fingerprint(&h, op->path, m->content);
+        else feed_str(&h, op->path);
+    }
+    for (int i = 0; i < m->ndeps; i++) fingerprint(&h, m->deps[i], m->content);
+    feed(&h, &m->content, sizeof(m->content));
+    snprintf(key, 33, "%016llx%016llx", h.a, h.b);
+}
+
+// -----------------------------------------------------------------------
+/* directorio de la caché (creándolo si hace falta); -1 si no se puede */
+static int cache_dir(char *buf, size_t size)
+{
+    const char *dir = var_get("MEMO_DIR");
+    if (dir && *dir) {
+        snprintf(buf, size, "%s", dir);
+    } else {
+        const char *base = var_get("XDG_CACHE_HOME");
+        if (base && *base) {
+            snprintf(buf, size, "%s/shell-memo", base);
+        } else {
+            if ((base = var_get("HOME")) == NULL) return -1;
+            snprintf(buf, size, "%s/.cache", base);
+            mkdir(buf, 0700);
+            snprintf(buf, size, "%s/.cache/shell-memo", base);
+        }
+    }
+    if (mkdir(buf, 0700) == -1 && errno != EEXIST) return -1;
+    return 0;
+}
+
+/* borra una entrada (o un directorio temporal a medio escribir) */
+static void remove_entry(const char *path)
+{
+    char file[4400];
+    DIR *d = opendir(path);
+    struct dirent *e;
+    if (d != NULL) {
+        while ((e = readdir(d)) != NULL) {
+            if (e->d_name[0] == '.') continue;
+            snprintf(file, sizeof(file), "%s/%s", path, e->d_name);
+            unlink(file);
+        }
+        closedir(d);
+    }
+    rmdir(path);
+}
+
+/* lista las entradas de la caché; devuelve cuántas hay (-1 si error) y
+   deja en *total los bytes que ocupan */
+static int scan(const char *dir, memo_entry **list, unsigned long long *total)
+{
+    char path[4352];
+    int n = 0, cap = 0;
+    DIR *d = opendir(dir);
+    struct dirent *e;
+    struct stat st;
+
+    *list = NULL;
+    *total = 0;
+    if (d == NULL) return -1;
+    while ((e = readdir(d)) != NULL) {
+        if (e->d_name[0] == '.' || strlen(e->d_name) != 32) continue; // ni temporales ni ajenos
+        snprintf(path, sizeof(path), "%s/%s", dir, e->d_name);
+        if (stat(path, &st) == -1 || !S_ISDIR(st.st_mode)) continue;
+        if (n == cap) {
+            memo_entry *grown = (memo_entry *) realloc(*list, (cap = cap ? 2 * cap : 64) * sizeof(memo_entry));
+            if (grown == NULL) break;
+            *list = grown;
+        }
+        memo_entry *m = &(*list)[n++];
+        strcpy(m->name, e->d_name);
+        m->used = st.st_mtim;
+        m->size = 0;
+        DIR *sub = opendir(path);
+        struct dirent *f;
+        while (sub && (f = readdir(sub)) != NULL) {
+            struct stat fst;
+            if (f->d_name[0] != '.' && fstatat(dirfd(sub), f->d_name, &fst, 0) == 0) m->size += fst.st_size;
+        }
+        if (sub) closedir(sub);
+        *total += m->size;
+    }
+    closedir(d);
+    return n;
+}
+
+static int older(const void *a, const void *b)
+{
+    const struct timespec *x = &((const memo_entry *) a)->used, *y = &((const memo_entry *) b)->used;
+    if (x->tv_sec != y->tv_sec) return (x->tv_sec < y->tv_sec) ? -1 : 1;
+    return (x->tv_nsec < y->tv_nsec) ? -1 : (x->tv_nsec > y->tv_nsec);
+}
+
+/* borra las entradas usadas hace más tiempo hasta caber en limit */
+static void evict(const char *dir)
+{
+    char path[4352];
+    memo_entry *list;
+    unsigned long long total;
+    int n = scan(dir, &list, &total);
+
+    if (n > 0 && total > limit) {
+        qsort(list, n, sizeof(memo_entry), older);
+        for (int i = 0; i < n && total > limit; i++) {
+            snprintf(path, sizeof(path), "%s/%s", dir, list[i].name);
+            remove_entry(path);
+            total -= list[i].size;
+            evictions++;
+        }
+    }
+    free(list);
+}
+
+// -----------------------------------------------------------------------
+/* copia el fichero src (de la caché) en el descriptor out. 0 si src no
+   existe (sección vacía) o se ha copiado, -1 si error */
+static int copy_from(const char *src, int out)
+{
+    int fd = open(src, O_RDONLY);
+    if (fd < 0) return (errno == ENOENT) ? 0 : -1;
+    int res = copy_fd(fd, out);
+    close(fd);
+    return res;
+}
+
+/* copia desde el descriptor in (desde el principio) a un fichero nuevo dst */
+static int copy_to(int in, const char *dst)
+{
+    int fd = open(dst, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd < 0) return -1;
+    int res = (lseek(in, 0, SEEK_SET) == -1) ? -1 : copy_fd(in, fd);
+    close(fd);
+    return res;
+}
+
+/* reproduce la entrada path. devuelve el estado guardado o -1 si la
+   entrada no existe o está dañada */
+static int replay(const char *path, const redir_list *redirs, long long *run_ns)
+{
+    char file[4400];
+    int status;
+    FILE *meta;
+
+    snprintf(file, sizeof(file), "%s/meta", path);
+    if ((meta = fopen(file, "r")) == NULL) return -1;
+    int ok = fscanf(meta, "%d %lld", &status, run_ns) == 2;
+    fclose(meta);
+    if (!ok) return -1;
+
+    for (int i = 0; i < redirs->n; i++) { // primero los ficheros, luego la salida
+        if (redirs->ops[i].type != REDIR_OUT) continue;
+        int fd = open(redirs->ops[i].path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+        snprintf(file, sizeof(file), "%s/r%d", path, i);
+        if (fd < 0 || copy_from(file, fd) == -1) {
+            fprintf(stderr, "memo: %s: %s\n", redirs->ops[i].path, strerror(errno));
+            if (fd >= 0) close(fd);
+            return -1;
+        }
+        close(fd);
+    }
+    snprintf(file, sizeof(file), "%s/out", path);
+    if (copy_from(file, STDOUT_FILENO) == -1) return -1;
+    utimensat(AT_FDCWD, path, NULL, 0); // último uso, para el LRU
+    return status;
+}
+
+/* guarda el resultado en dir/key: se escribe en un temporal y se
+   renombra, así otro shell nunca ve una entrada a medias */
+static int store(const char *dir, const char *key, int capture, const redir_list *redirs,
+                 int status, long long run_ns)
+{
+    char tmp[4352], file[4400], path[4352];
+    unsigned long long size = 0;
+    struct stat st;
+    FILE *meta;
+
+    snprintf(tmp, sizeof(tmp), "%s/.%s.%d", dir, key, getpid());
+    snprintf(path, sizeof(path), "%s/%s", dir, key);
+    if (mkdir(tmp, 0700) == -1) return -1;
+
+    snprintf(file, sizeof(file), "%s/meta", tmp);
+    if ((meta = fopen(file, "w")) == NULL) goto fail;
+    fprintf(meta, "%d %lld\n", status, run_ns);
+    if (fclose(meta) != 0) goto fail;
+
+    if (fstat(capture, &st) == 0 && st.st_size > 0) {
+        snprintf(file, sizeof(file), "%s/out", tmp);
+        if (copy_to(capture, file) == -1) goto fail;
+        size += st.st_size;
+    }
+    for (int i = 0; i < redirs->n; i++) {
+        if (redirs->ops[i].type != REDIR_OUT) continue;
+        int fd = open(redirs->ops[i].path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) goto fail;
+        snprintf(file, sizeof(file), "%s/r%d", tmp, i);
+        int res = (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode)) ? -1 : copy_to(fd, file);
+        close(fd);
+        if (res == -1) goto fail;
+        size += st.st_size;
+    }
+    if (size > limit) goto fail; // no cabe ni vaciando la caché
+    if (rename(tmp, path) == -1) goto fail; // otro shell la guardó antes
+    return 0;
+
+fail:
+    remove_entry(tmp);
+    return -1;
+}
+
+// -----------------------------------------------------------------------
+void init_memo_opts(memo_opts *m)
+{
+    m->nenv = 0;
+    m->ndeps = 0;
+    m->content = 0;
+}
+
+/* interpreta la opción que hay en args[*i]:  -e VAR  -d fichero  -H
+   devuelve 1 si la ha consumido (avanzando *i), 0 si no es una opción
+   de memo y -1 si es una opción mal formada */
+int parse_memo_opt(char **args, int *i, memo_opts *m)
+{
+    char *opt = args[*i];
+
+    if (strcmp(opt, "-H") == 0) {
+        m->content = 1;
+        *i += 1;
+        return 1;
+    }
+    if (strcmp(opt, "-e") && strcmp(opt, "-d")) return 0;
+    if (args[*i + 1] == NULL) return -1;
+    if (opt[1] == 'e') {
+        if (m->nenv == MEMO_MAX_KEYS) return -1;
+        m->env[m->nenv++] = args[*i + 1];
+    } else {
+        if (m->ndeps == MEMO_MAX_KEYS) return -1;
+        m->deps[m->ndeps++] = args[*i + 1];
+    }
+    *i += 2;
+    return 1;
+}
+
+// -----------------------------------------------------------------------
+/* proceso auxiliar que copia lo que llega por in a la salida estándar y
+   al memfd capture. Sigue en el grupo del shell: ctrl+c y ctrl+z solo
+   afectan al comando, y si este se suspende la copia continúa al
+   reanudarlo. devuelve su pid o -1 */
+static pid_t start_tee(int in, int capture)
+{
+    char buf[65536];
+    ssize_t n;
+    pid_t pid = fork();
+    if (pid != 0) return pid;
+
+    dup2(in, STDIN_FILENO);
+    if (capture != 3) dup2(capture, 3);
+    close_range(4, ~0U, 0); // que no mantenga abierta la tubería ni otros descriptores del shell
+    while ((n = read(STDIN_FILENO, buf, sizeof(buf))) != 0) {
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (ssize_t done = 0, w; done < n; done += w) { // la pantalla puede haberse cerrado
+            if ((w = write(STDOUT_FILENO, buf + done, n - done)) <= 0) break;
+        }
+        for (ssize_t done = 0, w; done < n; done += w) {
+            if ((w = write(3, buf + done, n - done)) <= 0) _exit(1);
+        }
+    }
+    _exit(0);
+}
+
+/* lanza argv y lo espera como el resto de comandos en primer plano: el
+   hijo tiene el terminal mientras dura y si se suspende se marca en
+   r->stopped. devuelve el estado de salida (128 + señal si lo mataron o
+   lo suspendieron) */
+static int run_foreground(char **argv, const launch_opts *opts, const redir_list *redirs,
+                          memo_result *r)
+{
+    int wstatus, info;
+
+    r->pid = spawn_job(argv, opts, redirs);
+    if (r->pid < 0) {
+        perror("memo: fork");
+        return 1;
+    }
+    set_terminal(r->pid);
+    wait_foreground(r->pid, &wstatus);
+    set_terminal(getpid());
+    enum status res = analyze_status(wstatus, &info);
+    r->stopped = (res == SUSPENDED);
+    return (res == EXITED) ? info : 128 + info;
+}
+
+// -----------------------------------------------------------------------
+/* ejecuta argv en primer plano a través de la caché. devuelve el estado
+   de salida (128 + señal si lo mataron o lo suspendieron) y deja en r
+   cómo ha ido. Si r->stopped el llamante debe añadir r->pid a la lista
+   de trabajos */
+int memo_run(char **argv, const memo_opts *m, const launch_opts *opts,
+             const redir_list *redirs, memo_result *r)
+{
+    char dir[4096], path[4352], key[33], capture_path[64];
+    struct timespec start, end;
+    int cacheable = 1, status, out = -1, pipefd[2];
+    sigset_t block, old;
+    pid_t tee = -1;
+    redir_list run;
+
+    r->hit = r->stored = r->stopped = 0;
+    r->pid = 0;
+    r->run_ns = 0;
+    for (int i = 0; i < redirs->n; i++) {
+        if (redirs->ops[i].type == REDIR_APPEND) cacheable = 0; // no se puede reproducir
+    }
+    if (cacheable && cache_dir(dir, sizeof(dir)) == -1) {
+        fprintf(stderr, "memo: no se puede crear el directorio de la caché\n");
+        cacheable = 0;
+    }
+    if (cacheable) {
+        make_key(argv, m, redirs, key);
+        snprintf(path, sizeof(path), "%s/%s", dir, key);
+        if ((status = replay(path, redirs, &r->run_ns)) >= 0) {
+            hits++;
+            saved_ns += r->run_ns;
+            r->hit = 1;
+            return status;
+        }
+        misses++;
+    }
+
+    // fallo: se ejecuta con la salida capturada (antes que las redirecciones propias).
+    // Las utilidades internas escriben directamente en el memfd; los comandos
+    // externos en una tubería que start_tee copia a la pantalla mientras se ejecutan
+    int fast = launch_opts_empty(opts) && is_fastcmd(argv, redirs);
+    int capture = memfd_create("memo", MFD_CLOEXEC);
+    sigemptyset(&block);
+    sigaddset(&block, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &block, &old); // hasta esperar al comando (wait_foreground)
+    if (capture >= 0 && redirs->n < MAX_REDIRS) {
+        if (fast) out = capture;
+        else if (ntees < (int) (sizeof(tees) / sizeof(tees[0])) && pipe2(pipefd, O_CLOEXEC) == 0) {
+            tee = start_tee(pipefd[0], capture);
+            close(pipefd[0]);
+            if (tee > 0) {
+                tees[ntees++] = tee; // puede terminar mientras se espera al comando
+                out = pipefd[1];
+            } else close(pipefd[1]);
+        }
+    }
+    run = *redirs;
+    if (out >= 0) {
+        memmove(&run.ops[1], &run.ops[0], run.n * sizeof(redir_op));
+        snprintf(capture_path, sizeof(capture_path), "/proc/%d/fd/%d", getpid(), out);
+        run.ops[0] = (redir_op) { REDIR_OUT, STDOUT_FILENO, 0, capture_path };
+        run.n++;
+    } else {
+        if (capture >= 0) close(capture);
+        capture = -1;
+        cacheable = 0;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (fast) {
+        status = run_fastcmd(argv, &run);
+        r->pid = getpid();
+    } else status = run_foreground(argv, opts, &run, r);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    r->run_ns = (end.tv_sec - start.tv_sec) * 1000000000LL + (end.tv_nsec - start.tv_nsec);
+
+    if (tee > 0) {
+        close(pipefd[1]);
+        // hasta que haya copiado todo; si el comando se suspendió sigue copiando
+        // al reanudarlo y la recoge sigchld_handler
+        if (!r->stopped && waitpid(tee, NULL, 0) == tee) memo_child_exited(tee, 0);
+    }
+    sigprocmask(SIG_SETMASK, &old, NULL);
+
+    if (capture >= 0) {
+        if (fast && lseek(capture, 0, SEEK_SET) == 0) copy_fd(capture, STDOUT_FILENO);
+        // no se guarda un comando suspendido, interrumpido, que no se pudo
+        // lanzar o que no se encontró o no se pudo ejecutar (126 y 127)
+        if (cacheable && r->pid > 0 && !r->stopped && status < 126 &&
+            store(dir, key, capture, redirs, status, r->run_ns) == 0) {
+            stores++;
+            r->stored = 1;
+            evict(dir);
+        }
+        close(capture);
+    }
+    return status;
+}
+
+/* sigchld_handler: devuelve 1 si pid es la copia de la salida de un
+   comando (y la olvida cuando termina) */
+int memo_child_exited(pid_t pid, int wstatus)
+{
+    for (int i = 0; i < ntees; i++) {
+        if (tees[i] != pid) continue;
+        if (!WIFSTOPPED(wstatus) && !WIFCONTINUED(wstatus)) tees[i] = tees[--ntees];
+        return 1;
+    }
+    return 0;
+}
+
+// -----------------------------------------------------------------------
+/* cambia el tamaño máximo de la caché (admite K, M y G) y la recorta
+   si hace falta. devuelve 0 o -1 si el tamaño no es válido */
+int memo_set_size(const char *size)
+{
+    char *end, dir[4096];
+    unsigned long long n = strtoull(size, &end, 10);
+
+    switch (*end) {
+        case 'K': case 'k': n <<= 10; end++; break;
+        case 'M': case 'm': n <<= 20; end++; break;
+        case 'G': case 'g': n <<= 30; end++; break;
+    }
+    if (*end != '\0' || n == 0 || size[0] == '-') return -1;
+    limit = n;
+    if (cache_dir(dir, sizeof(dir)) == 0) evict(dir);
+    return 0;
+}
+
+/* estadísticas de la sesión y ocupación de la caché */
+void memo_stats(void)
+{
+    char dir[4096];
+    memo_entry *list = NULL;
+    unsigned long long total = 0;
+    int n = (cache_dir(dir, sizeof(dir)) == 0) ? scan(dir, &list, &total) : -1;
+    unsigned long lookups = hits + misses;
+
+    free(list);
+    if (n < 0) {
+        printf("memo: no se puede leer la caché\n");
+        return;
+    }
+    printf("Memo cache: %s\n", dir);
+    printf(" entries: %d, size: %.1f of %.1f KiB\n", n, total / 1024.0, limit / 1024.0);
+    printf(" hits: %lu, misses: %lu (%.1f%% hit rate), stored: %lu, evicted: %lu\n",
+           hits, misses, lookups ? 100.0 * hits / lookups : 0.0, stores, evictions);
+    printf(" run time saved: %.3f s\n", saved_ns / 1e9);
+}
+
+/* vacía la caché. devuelve cuántas entradas se han borrado */
+int memo_clear(void)
+{
+    char dir[4096], path[4352];
+    memo_entry *list;
+    unsigned long long total;
+    int n;
+
+    if (cache_dir(dir, sizeof(dir)) == -1 || (n = scan(dir, &list, &total)) < 0) return 0;
+    for (int i = 0; i < n; i++) {
+        snprintf(path, sizeof(path), "%s/%s", dir, list[i].name);
+        remove_entry(path);
+    }
+    free(list);
+    return n;
+}
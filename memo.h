@@ -0,0 +1,52 @@
+/*--------------------------------------------------------
+UNIX Shell Project
+function prototypes and type declarations for memo module: caché en
+disco de la salida de comandos deterministas
+
+Sistemas Operativos
+Grados I. Informatica, Computadores & Software
+Dept. Arquitectura de Computadores - UMA
+Iván Ballesteros Fernández - 24-25 - 2ºGCIA
+--------------------------------------------------------*/
+
+#ifndef _MEMO_H
+#define _MEMO_H
+
+#include "launch.h"
+
+#define MEMO_MAX_KEYS 16                   /* -e y -d que se admiten de cada tipo */
+#define MEMO_CACHE_SIZE (64ULL << 20)      /* tamaño máximo de la caché por defecto */
+
+// ----------- OPCIONES DE memo -----------------------------------------
+typedef struct memo_opts_
+{
+	const char * env[MEMO_MAX_KEYS];  /* variables que forman parte de la clave */
+	int nenv;
+	const char * deps[MEMO_MAX_KEYS]; /* ficheros de los que depende el resultado */
+	int ndeps;
+	int content;                      /* huella por contenido en lugar de por mtime */
+} memo_opts;
+
+// ----------- RESULTADO DE UNA EJECUCIÓN -------------------------------
+typedef struct memo_result_
+{
+	int hit;          /* 1 si se ha reproducido desde la caché */
+	int stored;       /* 1 si se ha guardado (fallo de caché) */
+	int stopped;      /* 1 si se ha suspendido (ctrl+z): pasa a la lista de trabajos */
+	pid_t pid;        /* proceso que lo ejecutó (el shell si es una utilidad interna) */
+	long long run_ns; /* duración de la ejecución original */
+} memo_result;
+
+// -----------------------------------------------------------------------
+//      PUBLIC FUNCTIONS
+// -----------------------------------------------------------------------
+void init_memo_opts(memo_opts *m);
+int parse_memo_opt(char **args, int *i, memo_opts *m);
+int memo_run(char **argv, const memo_opts *m, const launch_opts *opts,
+             const redir_list *redirs, memo_result *r);
+int memo_set_size(const char *size);
+void memo_stats(void);
+int memo_clear(void);
+int memo_child_exited(pid_t pid, int wstatus);
+
+#endif
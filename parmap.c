@@ -0,0 +1,359 @@
+/*--------------------------------------------------------
+UNIX Shell Project
+parmap module: ejecuta el comando una vez por cada línea de la entrada
+(estilo xargs), con hasta K procesos a la vez
+
+Cada {} de los argumentos se sustituye por el elemento; si no hay
+ninguno, el elemento se añade como último argumento. Los hijos no están
+en la lista de trabajos: sigchld_handler los entrega a
+parmap_child_exited(), que anota el resultado y lanza el siguiente
+elemento, de modo que siempre hay K en marcha. Mientras tanto parmap()
+espera en sigsuspend y, con -k, vuelca en orden de entrada la salida de
+los que ya han terminado (cada hijo escribe en su propio memfd).
+ctrl+c deja de lanzar elementos y manda SIGTERM a los que están en marcha.
+
+Sistemas Operativos
+Grados I. Informatica, Computadores & Software
+Dept. Arquitectura de Computadores - UMA
+Iván Ballesteros Fernández - 24-25 - 2ºGCIA
+--------------------------------------------------------*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "parmap.h"
+#include "fastcmd.h"
+
+typedef struct pm_item_
+{
+	char * text;  /* elemento (línea de la entrada) */
+	int out_fd;   /* memfd con su salida (-k), -1 si no */
+	int done;     /* ha terminado (o no se pudo lanzar) */
+	int wstatus;  /* estado devuelto por waitpid, -1 si no se lanzó */
+} pm_item;
+
+static struct {
+	int active;          /* hay un parmap en curso */
+	pm_item *items;
+	int n;               /* elementos leídos */
+	int next;            /* siguiente elemento por lanzar */
+	int next_out;        /* siguiente elemento por volcar (-k) */
+	int finished, failed;
+	int jobs, ordered;
+	char **argv;         /* plantilla del comando */
+	int fds[3];          /* entrada, salida y error de parmap (redirecciones) */
+	pid_t *slot_pid;     /* hijos en marcha (jobs huecos) */
+	int *slot_item;
+	int running;
+} pm;
+
+static volatile sig_atomic_t interrupted = 0;
+
+// -----------------------------------------------------------------------
+static double elapsed(struct timespec *a, struct timespec *b)
+{
+    return (b->tv_sec - a->tv_sec) + (b->tv_nsec - a->tv_nsec) / 1e9;
+}
+
+static void sigint_handler(int sig)
+{
+    interrupted = 1;
+}
+
+// -----------------------------------------------------------------------
+/* lee toda la entrada (fichero, < o entrada del shell) y la parte en
+   líneas; las vacías se descartan. devuelve el nº de elementos o -1 */
+static int read_items(const char *path, char **data)
+{
+    int fd = path ? open(path, O_RDONLY) : pm.fds[0];
+    int len = 0, cap = 65536, n = 0, r;
+    char *buf = malloc(cap);
+
+    if (fd < 0 || buf == NULL) {
+        if (fd >= 0 && path) close(fd);
+        free(buf);
+        return -1;
+    }
+    for (;;) {
+        if (len + 1 == cap) {
+            char *tmp = realloc(buf, cap * 2);
+            if (tmp == NULL) break;
+            buf = tmp;
+            cap *= 2;
+        }
+        r = (fd != STDIN_FILENO) ? read(fd, buf + len, cap - 1 - len) : read_input(buf + len, cap - 1 - len);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) break;
+        len += r;
+    }
+    if (path) close(fd);
+    buf[len] = '\0';
+
+    for (char *p = buf; p < buf + len; p++) if (*p == '\n') n++;
+    pm.items = calloc(n + 1, sizeof(pm_item));
+    if (pm.items == NULL) {
+        free(buf);
+        return -1;
+    }
+    n = 0;
+    for (char *p = buf, *eol; p < buf + len; p = eol + 1) {
+        eol = strchr(p, '\n');
+        if (eol == NULL) eol = buf + len;
+        *eol = '\0';
+        if (*p == '\0') continue;
+        pm.items[n].text = p;
+        pm.items[n].out_fd = -1;
+        n++;
+    }
+    *data = buf;
+    return n;
+}
+
+// -----------------------------------------------------------------------
+/* argv del elemento: cada {} se sustituye por el texto del elemento */
+static char ** build_argv(const char *text)
+{
+    int argc = 0, subst = 0;
+    while (pm.argv[argc]) {
+        if (strstr(pm.argv[argc], "{}")) subst = 1;
+        argc++;
+    }
+    char **argv = calloc(argc + 2, sizeof(char *));
+    if (argv == NULL) return NULL;
+    size_t tlen = strlen(text);
+
+    for (int i = 0; i < argc; i++) {
+        const char *w = pm.argv[i], *hit;
+        int count = 0;
+        for (hit = w; (hit = strstr(hit, "{}")) != NULL; hit += 2) count++;
+        char *out = malloc(strlen(w) + count * tlen + 1), *o = out;
+        if (out == NULL) continue;
+        while ((hit = strstr(w, "{}")) != NULL) {
+            memcpy(o, w, hit - w);
+            o += hit - w;
+            memcpy(o, text, tlen);
+            o += tlen;
+            w = hit + 2;
+        }
+        strcpy(o, w);
+        argv[i] = out;
+    }
+    if (!subst) argv[argc] = strdup(text);
+    return argv;
+}
+
+static void free_argv(char **argv)
+{
+    for (int i = 0; argv[i]; i++) free(argv[i]);
+    free(argv);
+}
+
+// -----------------------------------------------------------------------
+/* añade a redirs la redirección de fd al descriptor own del shell; se
+   abre por /proc para que también valga cuando el hijo lo crea el lanzador
+   (zygote), en modo append para que los hijos no se pisen */
+static void redirect_to(redir_list *redirs, int fd, int own, char *path, int size)
+{
+    redir_op *op = &redirs->ops[redirs->n++];
+    snprintf(path, size, "/proc/%d/fd/%d", getpid(), own);
+    op->type = REDIR_APPEND;
+    op->fd = fd;
+    op->path = path;
+}
+
+/* lanza el elemento i en el hueco libre slot. la entrada de los hijos es
+   /dev/null; con -k su salida va a un memfd propio */
+static void launch_item(int i, int slot)
+{
+    pm_item *it = &pm.items[i];
+    char **argv = build_argv(it->text);
+    char out_path[64], err_path[64];
+    redir_list redirs;
+    pid_t pid = -1;
+
+    redirs.n = 1;
+    redirs.ops[0].type = REDIR_IN;
+    redirs.ops[0].fd = STDIN_FILENO;
+    redirs.ops[0].path = "/dev/null";
+    if (pm.ordered) {
+        it->out_fd = memfd_create("parmap", MFD_CLOEXEC);
+        redirect_to(&redirs, STDOUT_FILENO, it->out_fd, out_path, sizeof(out_path));
+    } else if (pm.fds[1] != STDOUT_FILENO) {
+        redirect_to(&redirs, STDOUT_FILENO, pm.fds[1], out_path, sizeof(out_path));
+    }
+    if (pm.fds[2] != STDERR_FILENO) redirect_to(&redirs, STDERR_FILENO, pm.fds[2], err_path, sizeof(err_path));
+    if (argv != NULL && (!pm.ordered || it->out_fd >= 0)) pid = spawn_job(argv, NULL, &redirs);
+    if (argv != NULL) free_argv(argv);
+
+    if (pid < 0) { // cuenta como fallido sin ocupar hueco
+        it->done = 1;
+        it->wstatus = -1;
+        pm.finished++;
+        pm.failed++;
+        return;
+    }
+    pm.slot_pid[slot] = pid;
+    pm.slot_item[slot] = i;
+    pm.running++;
+}
+
+/* ocupa los huecos libres mientras queden elementos; con -k no se adelanta
+   más de PARMAP_WINDOW elementos al primero que falta por volcar */
+static void launch_more(void)
+{
+    for (int slot = 0; slot < pm.jobs && !interrupted; slot++) {
+        if (pm.slot_pid[slot] != 0) continue;
+        while (pm.slot_pid[slot] == 0 && pm.next < pm.n &&
+               (!pm.ordered || pm.next - pm.next_out < pm.jobs + PARMAP_WINDOW)) {
+            launch_item(pm.next++, slot);
+        }
+    }
+}
+
+// -----------------------------------------------------------------------
+/* sigchld_handler: devuelve 1 si pid es un hijo de parmap (y lo procesa) */
+int parmap_child_exited(pid_t pid, int wstatus)
+{
+    if (!pm.active) return 0;
+    for (int slot = 0; slot < pm.jobs; slot++) {
+        if (pm.slot_pid[slot] != pid) continue;
+        if (WIFSTOPPED(wstatus) || WIFCONTINUED(wstatus)) return 1;
+        pm_item *it = &pm.items[pm.slot_item[slot]];
+        it->done = 1;
+        it->wstatus = wstatus;
+        if (!WIFEXITED(wstatus) || WEXITSTATUS(wstatus) != 0) pm.failed++;
+        pm.finished++;
+        pm.slot_pid[slot] = 0;
+        pm.running--;
+        launch_more();
+        return 1;
+    }
+    return 0;
+}
+
+// -----------------------------------------------------------------------
+/* -k: vuelca, en orden de entrada, la salida de los elementos terminados */
+static void flush_ordered(void)
+{
+    int launched = 0;
+    fflush(stdout);
+    while (pm.next_out < pm.n && pm.items[pm.next_out].done) {
+        pm_item *it = &pm.items[pm.next_out++];
+        if (it->out_fd >= 0) {
+            if (lseek(it->out_fd, 0, SEEK_SET) == 0) copy_fd(it->out_fd, pm.fds[1]);
+            close(it->out_fd);
+            it->out_fd = -1;
+        }
+        launched = 1;
+    }
+    if (launched) launch_more(); // la ventana ha avanzado
+}
+
+// -----------------------------------------------------------------------
+/* informe final: rendimiento y elementos fallidos */
+static void report(double secs)
+{
+    int shown = 0;
+    printf("parmap: %d elementos, %d fallidos, %.3f s, %.1f elementos/s\n",
+           pm.finished, pm.failed, secs, secs > 0 ? pm.finished / secs : 0.0);
+    if (pm.finished < pm.n) printf("parmap: interrumpido, %d elementos sin terminar\n", pm.n - pm.finished);
+    for (int i = 0; i < pm.n && shown < PARMAP_SHOW_FAILED; i++) {
+        pm_item *it = &pm.items[i];
+        if (!it->done || (it->wstatus != -1 && WIFEXITED(it->wstatus) && WEXITSTATUS(it->wstatus) == 0)) continue;
+        if (it->wstatus == -1) printf(" fallido: %s (no se pudo lanzar)\n", it->text);
+        else if (WIFSIGNALED(it->wstatus)) printf(" fallido: %s (señal %d)\n", it->text, WTERMSIG(it->wstatus));
+        else printf(" fallido: %s (exit %d)\n", it->text, WEXITSTATUS(it->wstatus));
+        shown++;
+    }
+    if (pm.failed > shown) printf(" ... y %d más\n", pm.failed - shown);
+}
+
+// -----------------------------------------------------------------------
+/* ejecuta argv para cada elemento de path (o de la entrada, redirigida o
+   del shell, si es NULL) con jobs procesos a la vez. las redirecciones de
+   salida y error se aplican a los hijos. devuelve el nº de elementos
+   fallidos o -1 si no se pudo leer la entrada */
+int parmap(char **argv, int jobs, int ordered, const char *path, const redir_list *redirs)
+{
+    char *data = NULL;
+    struct timespec start, end;
+    sigset_t block, old, wait_mask;
+    struct sigaction sa, old_int;
+    int failed, signalled = 0;
+
+    memset(&pm, 0, sizeof(pm));
+    if (open_redirections(redirs, pm.fds) == -1) return -1;
+    pm.n = read_items(path, &data);
+    if (pm.n < 0) {
+        close_redirections(pm.fds);
+        return -1;
+    }
+    pm.argv = argv;
+    pm.jobs = jobs;
+    pm.ordered = ordered;
+    pm.slot_pid = calloc(jobs, sizeof(pid_t));
+    pm.slot_item = calloc(jobs, sizeof(int));
+    if (pm.slot_pid == NULL || pm.slot_item == NULL) {
+        free(pm.slot_pid);
+        free(pm.slot_item);
+        free(pm.items);
+        free(data);
+        close_redirections(pm.fds);
+        return -1;
+    }
+
+    // ctrl+c llega al shell (los hijos no tienen el terminal)
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = sigint_handler;
+    sigemptyset(&sa.sa_mask);
+    interrupted = 0;
+    sigaction(SIGINT, &sa, &old_int);
+
+    // SIGCHLD y SIGINT solo se atienden dentro de sigsuspend
+    sigemptyset(&block);
+    sigaddset(&block, SIGCHLD);
+    sigaddset(&block, SIGINT);
+    sigprocmask(SIG_BLOCK, &block, &old);
+    wait_mask = old;
+    sigdelset(&wait_mask, SIGCHLD);
+    sigdelset(&wait_mask, SIGINT);
+
+    fflush(stdout);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pm.active = 1;
+    launch_more();
+    for (;;) {
+        if (pm.ordered) flush_ordered();
+        if (interrupted && !signalled) {
+            for (int slot = 0; slot < pm.jobs; slot++) {
+                if (pm.slot_pid[slot] != 0) killpg(pm.slot_pid[slot], SIGTERM);
+            }
+            signalled = 1;
+        }
+        if (pm.running == 0 && (pm.next == pm.n || interrupted)) break;
+        sigsuspend(&wait_mask);
+    }
+    pm.active = 0;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (pm.ordered) flush_ordered();
+
+    sigprocmask(SIG_SETMASK, &old, NULL);
+    sigaction(SIGINT, &old_int, NULL);
+
+    report(elapsed(&start, &end));
+    failed = pm.failed + (pm.n - pm.finished);
+    for (int i = 0; i < pm.n; i++) if (pm.items[i].out_fd >= 0) close(pm.items[i].out_fd);
+    free(pm.slot_pid);
+    free(pm.slot_item);
+    free(pm.items);
+    free(data);
+    close_redirections(pm.fds);
+    return failed;
+}
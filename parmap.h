@@ -0,0 +1,26 @@
+/*--------------------------------------------------------
+UNIX Shell Project
+function prototypes for parmap module: un comando por cada elemento de
+la entrada con K procesos en paralelo
+
+Sistemas Operativos
+Grados I. Informatica, Computadores & Software
+Dept. Arquitectura de Computadores - UMA
+Iván Ballesteros Fernández - 24-25 - 2ºGCIA
+--------------------------------------------------------*/
+
+#ifndef _PARMAP_H
+#define _PARMAP_H
+
+#include "job_control.h"
+
+#define PARMAP_WINDOW 256 /* con -k, elementos terminados que pueden esperar turno */
+#define PARMAP_SHOW_FAILED 20 /* elementos fallidos que se listan en el informe */
+
+// -----------------------------------------------------------------------
+//      PUBLIC FUNCTIONS
+// -----------------------------------------------------------------------
+int parmap(char **argv, int jobs, int ordered, const char *path, const redir_list *redirs);
+int parmap_child_exited(pid_t pid, int wstatus);
+
+#endif
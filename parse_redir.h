@@ -1,5 +1,5 @@
 // -----------------------------------------------------------------------
-// Parse redirections operators '<' '>' once args structure has been built.
+// Parse redirections operators once args structure has been built.
 // Include this file and call the function immediately after get_commad():
 //
 //     #include "parse_redir.h"
@@ -8,45 +8,94 @@
 //          // Shell main loop
 //          ...
 //          get_command(...);
-//          char *file_in, *file_out;
-//          parse_redirections(args, &file_in, &file_out);
+//          redir_list redirs;
+//          parse_redirections(args, tokenize_literal(), &redirs);
 //          ...
 //     }
 //
-// For a valid redirection, a blank space is required before and after
-// redirection operators '<' or '>'.
+// Supported operators (a blank space is required before and after them):
+//     < file     > file     >> file     n> file     n>> file     n< file
+//     n>&m       &> file    &>> file    <<< word
+// Operators are stored in order in a redir_list (see launch.h) that the
+// child applies with apply_redirections(); args is compacted in one pass.
 // Iván Ballesteros Fernández - 24-25 - 2ºGCIA
 // --------------------------------------------------------------
 
-static void parse_redirections(char **args,  char **file_in, char **file_out){
-    *file_in = NULL;
-    *file_out = NULL;
+#ifndef _PARSE_REDIR_H
+#define _PARSE_REDIR_H
+
+// Reconoce un operador. Devuelve 1 y rellena op (salvo la ruta) si lo es
+static int parse_redir_op(const char *tok, redir_op *op, int *both)
+{
+    int fd = -1;
+    *both = 0;
+    if (tok[0] == '&' && tok[1] == '>') { // &> y &>>: salida y errores al mismo fichero
+        *both = 1;
+        tok++;
+        fd = STDOUT_FILENO;
+    } else if (tok[0] >= '0' && tok[0] <= '9' && tok[1] != '\0') {
+        fd = tok[0] - '0';
+        tok++;
+    }
+
+    if (strcmp(tok, "<<<") == 0 && fd == -1) {
+        op->type = REDIR_HERESTR;
+        op->fd = STDIN_FILENO;
+    } else if (strcmp(tok, "<") == 0 && !*both) {
+        op->type = REDIR_IN;
+        op->fd = (fd == -1) ? STDIN_FILENO : fd;
+    } else if (strcmp(tok, ">") == 0) {
+        op->type = REDIR_OUT;
+        op->fd = (fd == -1) ? STDOUT_FILENO : fd;
+    } else if (strcmp(tok, ">>") == 0) {
+        op->type = REDIR_APPEND;
+        op->fd = (fd == -1) ? STDOUT_FILENO : fd;
+    } else if (tok[0] == '>' && tok[1] == '&' && tok[2] >= '0' && tok[2] <= '9' && tok[3] == '\0' && !*both) {
+        op->type = REDIR_DUP; // n>&m: no lleva fichero
+        op->fd = (fd == -1) ? STDOUT_FILENO : fd;
+        op->target = tok[2] - '0';
+        op->path = NULL;
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+// literal[i] != 0 marks the words the tokenizer built from quotes, escapes
+// or expansions: they are never operators ("echo '>' x" prints "> x").
+// literal may be NULL.
+static void parse_redirections(char **args, const unsigned char *literal, redir_list *redirs){
     char **args_start = args;
-    while (*args) {
-        int is_in = !strcmp(*args, "<");
-        int is_out = !strcmp(*args, ">");
-        if (is_in || is_out) {
-            args++;
-            if (*args){
-                if (is_in)  *file_in = *args;
-                if (is_out) *file_out = *args;
-                char **aux = args + 1;
-                while (*aux) {
-                   *(aux-2) = *aux;
-                   aux++;    
-                }
-                *(aux-2) = NULL;
-                args--;
-            } else {
-                /* Syntax error */
-                args_start[0] = NULL; // Do nothing
-            }
+    char **out = args; // los argumentos normales se compactan sobre el propio array
+    redir_op op;
+    int both, error = 0;
+
+    redirs->n = 0;
+    while (*args && !error) {
+        if ((literal && literal[args - args_start]) || !parse_redir_op(*args, &op, &both)) {
+            *out++ = *args++;
+            continue;
+        }
+        if (op.type != REDIR_DUP && (op.path = *(++args)) == NULL) {
+            error = 1; /* Syntax error: falta el fichero */
+        } else if (redirs->n + both >= MAX_REDIRS) {
+            error = 1; /* Syntax error: demasiadas redirecciones */
         } else {
-            args++; 
+            redirs->ops[redirs->n++] = op;
+            if (both) { // &> f equivale a > f 2>&1
+                redir_op dup = { REDIR_DUP, STDERR_FILENO, STDOUT_FILENO, NULL };
+                redirs->ops[redirs->n++] = dup;
+            }
+            args++;
         }
     }
+    *out = NULL;
+    if (error) {
+        args_start[0] = NULL; // Do nothing
+    }
     // Debug:
-    // *file_in && fprintf(stderr, "[parse_redirections] file_in='%s'\n", *file_in);
-    // *file_out && fprintf(stderr, "[parse_redirections] file_out='%s'\n", *file_out);
+    // for (int i = 0; i < redirs->n; i++)
+    //     fprintf(stderr, "[parse_redirections] type=%d fd=%d path='%s'\n", redirs->ops[i].type, redirs->ops[i].fd, redirs->ops[i].path);
 }
 
+#endif
@@ -0,0 +1,565 @@
+/*--------------------------------------------------------
+UNIX Shell Project
+tokenizer module: separa una línea de órdenes en argumentos
+
+Reglas:
+  - Los argumentos se separan con espacios o tabuladores.
+  - 'texto' se copia tal cual; "texto" admite \" \\ \$ y \` como escapes.
+  - Fuera de comillas, \c deja el carácter c como literal.
+  - $NOMBRE, ${NOMBRE}, $? y $$ se expanden fuera de comillas simples.
+  - $(orden) se sustituye por la salida de la orden (módulo cmdsubst);
+    fuera de comillas dobles se parte en argumentos por los espacios.
+  - *, ?, [...] y ** sin comillas se expanden a las rutas que encajan
+    (módulo wildcard).
+  - Solo un & o + sin comillas al final de la línea es operador de trabajo
+    (segundo plano / respawnable); en cualquier otro sitio es texto.
+Los argumentos se construyen en una sola pasada sobre un buffer propio y
+los tramos sin caracteres especiales se saltan con SSE2/AVX2 y se copian
+de una vez.
+
+Sistemas Operativos
+Grados I. Informatica, Computadores & Software
+Dept. Arquitectura de Computadores - UMA
+Iván Ballesteros Fernández - 24-25 - 2ºGCIA
+--------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include "tokenizer.h"
+#include "vars.h"
+#include "wildcard.h"
+#include "cmdsubst.h"
+
+/* bytes en los que el tokenizador tiene que pararse */
+static const char stop_bytes[10] = { ' ', '\t', '\n', '\'', '"', '\\', '$', '*', '?', '[' };
+#define NSTOP ((int) sizeof(stop_bytes))
+static unsigned char special[256];
+static int bench = 0; // parse_bench: $(...) y comodines se dejan como texto, sin ejecutar ni leer directorios
+
+// -----------------------------------------------------------------------
+/* devuelve la primera posición de [p, end) con un byte especial, o end.
+   Los diez bytes de stop_bytes se comparan a la vez sobre 32 (AVX2) o
+   16 (SSE2) bytes de la línea */
+static char *skip_plain(char *p, char *end)
+{
+#if defined(__AVX2__)
+#define EQ32(k) _mm256_cmpeq_epi8(v, _mm256_set1_epi8(stop_bytes[k]))
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *) p);
+        __m256i m = _mm256_or_si256(
+            _mm256_or_si256(_mm256_or_si256(EQ32(0), EQ32(1)), _mm256_or_si256(EQ32(2), EQ32(3))),
+            _mm256_or_si256(_mm256_or_si256(_mm256_or_si256(EQ32(4), EQ32(5)), _mm256_or_si256(EQ32(6), EQ32(7))),
+                            _mm256_or_si256(EQ32(8), EQ32(9))));
+        unsigned mask = (unsigned) _mm256_movemask_epi8(m);
+        if (mask) return p + __builtin_ctz(mask);
+        p += 32;
+    }
+#undef EQ32
+#endif
+#if defined(__SSE2__)
+#define EQ16(k) _mm_cmpeq_epi8(v, _mm_set1_epi8(stop_bytes[k]))
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *) p);
+        __m128i m = _mm_or_si128(
+            _mm_or_si128(_mm_or_si128(EQ16(0), EQ16(1)), _mm_or_si128(EQ16(2), EQ16(3))),
+            _mm_or_si128(_mm_or_si128(_mm_or_si128(EQ16(4), EQ16(5)), _mm_or_si128(EQ16(6), EQ16(7))),
+                         _mm_or_si128(EQ16(8), EQ16(9))));
+        unsigned mask = (unsigned) _mm_movemask_epi8(m);
+        if (mask) return p + __builtin_ctz(mask);
+        p += 16;
+    }
+#undef EQ16
+#endif
+    while (p < end && !special[(unsigned char) *p]) p++;
+    return p;
+}
+
+// -----------------------------------------------------------------------
+/* los argumentos se escriben en un buffer propio y el vector de punteros
+   también es propio; los dos crecen cuando hace falta y siguen valiendo
+   hasta la siguiente llamada */
+static char *arena = NULL;
+static size_t arena_cap = 0;
+static char **argv_buf = NULL;
+static unsigned char *literal_buf = NULL; // literal_buf[i]: argv_buf[i] no puede ser un operador
+static int argv_cap = 0;
+
+typedef struct tok_state_
+{
+	char * w;     /* siguiente byte libre en arena */
+	char * tok;   /* inicio del argumento en curso, NULL entre argumentos */
+	int glob;     /* el argumento tiene *, ? o [ sin comillas */
+	int escaped;  /* el argumento tiene caracteres protegidos con '\' */
+	int literal;  /* el argumento tiene comillas, escapes o expansiones */
+	int ct;       /* argumentos cerrados */
+} tok_state;
+
+/* garantiza need bytes libres a partir de st->w. Si hay que cambiar de
+   buffer se recolocan w, tok y los argumentos ya cerrados */
+static int reserve(tok_state *st, size_t need)
+{
+    size_t used = arena ? st->w - arena : 0;
+    if (used + need <= arena_cap) return 0;
+
+    size_t cap = arena_cap ? arena_cap : 256;
+    while (cap < used + need) cap *= 2;
+    char *a = (char *) malloc(cap);
+    if (a == NULL) return -1;
+    if (arena != NULL) {
+        memcpy(a, arena, used);
+        for (int i = 0; i < st->ct; i++) argv_buf[i] = a + (argv_buf[i] - arena);
+        if (st->tok != NULL) st->tok = a + (st->tok - arena);
+        free(arena);
+    }
+    arena = a;
+    arena_cap = cap;
+    st->w = a + used;
+    return 0;
+}
+
+static inline int push_arg(tok_state *st, char *arg, int literal)
+{
+    if (__builtin_expect(st->ct + 1 >= argv_cap, 0)) { // siempre queda sitio para el NULL final
+        int cap = argv_cap ? argv_cap * 2 : 64;
+        char **v = (char **) realloc(argv_buf, cap * sizeof(char *));
+        if (v == NULL) return -1;
+        argv_buf = v;
+        unsigned char *l = (unsigned char *) realloc(literal_buf, cap);
+        if (l == NULL) return -1;
+        literal_buf = l;
+        argv_cap = cap;
+    }
+    literal_buf[st->ct] = literal;
+    argv_buf[st->ct++] = arg;
+    return 0;
+}
+
+/* escribe un carácter que viene entre comillas, escapado o de una
+   variable: si es un comodín o '\' se protege para la expansión */
+static inline void put_literal(tok_state *st, char c)
+{
+    st->literal = 1;
+    if (c == '*' || c == '?' || c == '[' || c == '\\') {
+        *st->w++ = '\\';
+        st->escaped = 1;
+    }
+    *st->w++ = c;
+}
+
+static inline void start_arg(tok_state *st)
+{
+    if (st->tok == NULL) {
+        st->tok = st->w;
+        st->glob = 0;
+        st->escaped = 0;
+        st->literal = 0;
+    }
+}
+
+/* cierra el argumento en curso. Si tiene comodines se sustituye por las
+   rutas que encajan (si no encaja ninguna se deja tal cual, como bash).
+   remaining: bytes de la línea aún sin leer */
+static inline int finish_arg(tok_state *st, size_t remaining)
+{
+    char *arg = st->tok;
+    *st->w++ = '\0';
+    st->tok = NULL;
+
+    if (__builtin_expect(!st->glob && !st->escaped, 1)) return push_arg(st, arg, st->literal);
+    if (st->glob && !bench) {
+        char **matches;
+        int n = wildcard_expand(arg, &matches);
+        for (int i = 0; i < n; i++) {
+            size_t len = strlen(matches[i]) + 1;
+            if (reserve(st, len + 2 * remaining + 2) == -1 || push_arg(st, st->w, 1) == -1) {
+                wildcard_free(matches, n);
+                return -1;
+            }
+            memcpy(st->w, matches[i], len);
+            st->w += len;
+        }
+        wildcard_free(matches, n);
+        if (n > 0) return 0;
+    }
+    if (st->escaped) wildcard_unescape(arg);
+    return push_arg(st, arg, st->literal);
+}
+
+// -----------------------------------------------------------------------
+/* busca el ')' que cierra el $( que empieza en p; las comillas y los
+   escapes de dentro no cuentan. NULL si no está en la línea */
+static char *find_close(char *p, char *end)
+{
+    int depth = 1;
+    for (; p < end; p++) {
+        switch (*p) {
+        case '\\':
+            p++;
+            break;
+        case '\'':
+            if ((p = memchr(p + 1, '\'', end - p - 1)) == NULL) return NULL;
+            break;
+        case '"':
+            for (p++; p < end && *p != '"'; p++) if (*p == '\\') p++;
+            if (p >= end) return NULL;
+            break;
+        case '(':
+            depth++;
+            break;
+        case ')':
+            if (--depth == 0) return p;
+            break;
+        }
+    }
+    return NULL;
+}
+
+/* $(...): ejecuta la orden con el tokenizador libre (sus buffers se
+   apartan y se recuperan después) y escribe la salida en el argumento en
+   curso. Fuera de comillas se parte en espacios, tabuladores y saltos de
+   línea; los trozos no se expanden como patrones */
+static int substitute(tok_state *st, char *text, int length, int in_dquote, size_t remaining)
+{
+    char *saved_arena = arena, **saved_argv = argv_buf;
+    unsigned char *saved_literal = literal_buf;
+    size_t saved_cap = arena_cap;
+    int saved_argc = argv_cap;
+    cmdsubst_out out;
+
+    arena = NULL;
+    arena_cap = 0;
+    argv_buf = NULL;
+    literal_buf = NULL;
+    argv_cap = 0;
+    int res = cmdsubst_run(text, length, &out);
+    free(arena);
+    free(argv_buf);
+    free(literal_buf);
+    arena = saved_arena;
+    arena_cap = saved_cap;
+    argv_buf = saved_argv;
+    literal_buf = saved_literal;
+    argv_cap = saved_argc;
+    if (res < 0) return res;
+
+    if (reserve(st, 2 * (out.len + remaining) + 2) == -1) res = TOK_ERR_SUBST;
+    else if (in_dquote) {
+        start_arg(st);
+        st->literal = 1;
+        for (size_t i = 0; i < out.len; i++) put_literal(st, out.data[i]);
+    } else {
+        for (size_t i = 0; i < out.len && res == 0; i++) {
+            char c = out.data[i];
+            if (c == ' ' || c == '\t' || c == '\n') {
+                if (st->tok != NULL && finish_arg(st, remaining + out.len - i) == -1) res = TOK_ERR_SUBST;
+            } else {
+                start_arg(st);
+                put_literal(st, c);
+            }
+        }
+    }
+    cmdsubst_release(&out);
+    return res;
+}
+
+// -----------------------------------------------------------------------
+/* separa line[0..length) (sin el '\n') en argumentos, expandiendo
+   $NOMBRE, ${NOMBRE}, $?, $$ y $(orden) fuera de comillas simples y los comodines
+   sin comillas. El valor de una variable no se vuelve a partir ni se
+   expande como patrón. Deja en *args el vector terminado en NULL.
+   devuelve el número de argumentos o TOK_ERR_QUOTE / TOK_ERR_SUBST */
+int tokenize_line(char *line, int length, char ***args, int *background, int *respawnable)
+{
+    tok_state st = { arena, NULL, 0, 0, 0, 0 };
+    char *r = line, *end;
+    int in_dquote = 0;
+
+    if (!special[' ']) {
+        for (int k = 0; k < NSTOP; k++) special[(unsigned char) stop_bytes[k]] = 1;
+    }
+    if (push_arg(&st, NULL, 0) == -1) return TOK_ERR_SUBST; // el vector siempre existe
+    st.ct = 0;
+    *args = argv_buf;
+    argv_buf[0] = NULL;
+
+    // & o + al final (sin escapar) es el operador de trabajo
+    while (length > 0 && (line[length - 1] == ' ' || line[length - 1] == '\t')) length--;
+    if (length > 0 && (line[length - 1] == '&' || line[length - 1] == '+')) {
+        int backslashes = 0;
+        while (backslashes < length - 1 && line[length - 2 - backslashes] == '\\') backslashes++;
+        if (backslashes % 2 == 0) {
+            if (line[length - 1] == '+') *respawnable = 1;
+            *background = 1;
+            length--;
+        }
+    }
+    end = line + length;
+
+    // sin expansiones cada byte de la línea produce como mucho dos
+    if (reserve(&st, 2 * (size_t) length + 2) == -1) return TOK_ERR_SUBST;
+
+    while (r < end) {
+        char *q = skip_plain(r, end);
+        if (q > r) { // tramo sin especiales: se copia entero
+            start_arg(&st);
+            memcpy(st.w, r, q - r);
+            st.w += q - r;
+            r = q;
+            if (r == end) break;
+        }
+
+        char c = *r++;
+        if (c == '$') {
+            const char *name = r;
+            size_t len = 0;
+            if (r < end && *r == '(') { // $(orden)
+                char *close = find_close(r + 1, end);
+                if (close == NULL) return TOK_ERR_SUBST;
+                if (bench) {
+                    start_arg(&st);
+                    for (char *t = r - 1; t <= close; t++) put_literal(&st, *t);
+                    r = close + 1;
+                    continue;
+                }
+                int res = substitute(&st, r + 1, close - r - 1, in_dquote, end - close - 1);
+                if (res < 0) return res;
+                r = close + 1;
+                continue;
+            }
+            if (r < end && *r == '{') {
+                char *close = memchr(r, '}', end - r);
+                if (close == NULL || !var_valid_name(r + 1, close - r - 1)) return TOK_ERR_SUBST;
+                name = r + 1;
+                len = close - r - 1;
+                r = close + 1;
+            } else if (r < end && (*r == '?' || *r == '$')) {
+                len = 1;
+                r++;
+            } else {
+                while (r + len < end && (r[len] == '_' || isalpha((unsigned char) r[len]) ||
+                                         (len > 0 && isdigit((unsigned char) r[len])))) len++;
+                r += len;
+            }
+            if (len == 0) { // no es una expansión: '$' literal
+                start_arg(&st);
+                *st.w++ = c;
+                continue;
+            }
+            const char *value = var_lookup(name, len);
+            size_t vlen = value ? strlen(value) : 0;
+            if (vlen > 0 || in_dquote) {
+                if (reserve(&st, 2 * (vlen + (end - r)) + 2) == -1) return TOK_ERR_SUBST;
+                start_arg(&st);
+                st.literal = 1;
+                for (size_t i = 0; i < vlen; i++) put_literal(&st, value[i]);
+            }
+            continue;
+        }
+        if (in_dquote) {
+            if (c == '"') {
+                in_dquote = 0;
+            } else if (c == '\\' && r < end && (*r == '"' || *r == '\\' || *r == '$' || *r == '`')) {
+                put_literal(&st, *r++);
+            } else {
+                put_literal(&st, c);
+            }
+            continue;
+        }
+
+        switch (c) {
+        case ' ':
+        case '\t':
+        case '\n':
+            if (st.tok != NULL && finish_arg(&st, end - r) == -1) return TOK_ERR_SUBST;
+            break;
+        case '*':
+        case '?':
+        case '[':
+            start_arg(&st);
+            st.glob = 1;
+            *st.w++ = c;
+            break;
+        case '\'': {
+            char *close = memchr(r, '\'', end - r);
+            if (close == NULL) return TOK_ERR_QUOTE;
+            start_arg(&st);
+            st.literal = 1;
+            for (; r < close; r++) put_literal(&st, *r);
+            r = close + 1;
+            break;
+        }
+        case '"':
+            start_arg(&st);
+            st.literal = 1;
+            in_dquote = 1;
+            break;
+        case '\\': // una barra al final de la línea se deja como texto
+            start_arg(&st);
+            put_literal(&st, r < end ? *r++ : c);
+            break;
+        }
+    }
+    if (in_dquote) return TOK_ERR_QUOTE;
+    if (st.tok != NULL && finish_arg(&st, 0) == -1) return TOK_ERR_SUBST;
+
+    argv_buf[st.ct] = NULL;
+    *args = argv_buf; // push_arg puede haber movido el vector
+    return st.ct;
+}
+
+/* marcas de los argumentos del último tokenize_line: 1 si el argumento
+   viene de comillas, escapes o expansiones y por tanto no es un operador
+   de redirección. Vale hasta la siguiente llamada */
+const unsigned char * tokenize_literal(void)
+{
+    return literal_buf;
+}
+
+// -----------------------------------------------------------------------
+/* bucle original de get_command (sin comillas, & y + en cualquier sitio
+   terminan la línea). Solo se conserva para compararlo en parse_bench */
+int tokenize_line_legacy(char *line, int length, char *args[], int *background, int *respawnable)
+{
+    int i;
+    int start = -1;
+    int ct = 0;
+
+    for (i = 0; i < length; i++) {
+        switch (line[i]) {
+        case ' ':
+        case '\t':
+            if (start != -1) {
+                args[ct] = &line[start];
+                ct++;
+            }
+            line[i] = '\0';
+            start = -1;
+            break;
+        case '\n':
+            if (start != -1) {
+                args[ct] = &line[start];
+                ct++;
+            }
+            line[i] = '\0';
+            args[ct] = NULL;
+            break;
+        default :
+            if (line[i] == '&' || line[i] == '+') {
+                if (line[i] == '+') *respawnable = 1;
+                *background = 1;
+                if (start != -1) {
+                    args[ct] = &line[start];
+                    ct++;
+                }
+                line[i] = '\0';
+                args[ct] = NULL;
+                i = length;
+            }
+            else if (start == -1) {
+                start = i;
+            }
+        }
+    }
+    args[ct] = NULL;
+    return ct;
+}
+
+// -----------------------------------------------------------------------
+static double elapsed(struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/* tokeniza reps veces todas las líneas del fichero con los dos bucles y
+   muestra el rendimiento de cada uno. Cada línea se copia antes a un
+   buffer aparte porque ambos escriben sobre ella */
+void parse_bench(const char *path, int reps)
+{
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        perror("parsebench");
+        return;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    rewind(f);
+    char *text = malloc(size + 1);
+    if (text == NULL || fread(text, 1, size, f) != (size_t) size) {
+        perror("parsebench");
+        free(text);
+        fclose(f);
+        return;
+    }
+    fclose(f);
+    if (size == 0) {
+        printf("parsebench: %s está vacío\n", path);
+        free(text);
+        return;
+    }
+    text[size] = '\n';
+
+    // inicio de cada línea y la más larga
+    long nlines = 0, max_len = 0;
+    for (char *p = text; p < text + size; p = (char *) memchr(p, '\n', text + size + 1 - p) + 1) nlines++;
+    long *starts = malloc((nlines + 1) * sizeof(long));
+    long n = 0;
+    for (char *p = text; p < text + size; p = (char *) memchr(p, '\n', text + size + 1 - p) + 1) {
+        starts[n++] = p - text;
+    }
+    starts[n] = size + 1;
+    for (long i = 0; i < nlines; i++) {
+        if (starts[i + 1] - starts[i] > max_len) max_len = starts[i + 1] - starts[i];
+    }
+
+    char *scratch = malloc(max_len + 1);
+    char **args = malloc((max_len / 2 + 2) * sizeof(char *)); // bucle original
+    char **argv;                                              // tokenizador
+    int bg, resp;
+    double secs[2];
+    long tokens[2], errors = 0;
+
+    bench = 1; // se mide el tokenizador, no las órdenes de los $(...) ni el sistema de ficheros
+    for (int impl = 0; impl < 2; impl++) {
+        struct timespec start;
+        tokens[impl] = 0;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int k = 0; k < reps; k++) {
+            for (long i = 0; i < nlines; i++) {
+                long len = starts[i + 1] - starts[i]; // incluye el '\n'
+                memcpy(scratch, text + starts[i], len);
+                bg = resp = 0;
+                if (impl == 0) {
+                    tokens[impl] += tokenize_line_legacy(scratch, len, args, &bg, &resp);
+                } else {
+                    int res = tokenize_line(scratch, len - 1, &argv, &bg, &resp);
+                    if (res >= 0) tokens[impl] += res;
+                    else errors++; // TOK_ERR_*: no son argumentos
+                }
+            }
+        }
+        secs[impl] = elapsed(&start);
+    }
+    bench = 0;
+
+    double mb = (double) size * reps / (1024 * 1024);
+    printf("parsebench: %ld líneas, %ld bytes, %d repeticiones\n", nlines, size, reps);
+    printf("  bucle original: %8.3f s %10.1f MB/s %12ld argumentos\n", secs[0], mb / secs[0], tokens[0]);
+    printf("  tokenizador:    %8.3f s %10.1f MB/s %12ld argumentos\n", secs[1], mb / secs[1], tokens[1]);
+    if (errors > 0) printf("  líneas con error de sintaxis: %ld (no cuentan como argumentos)\n", errors / reps);
+    printf("  aceleración: %.2fx\n", secs[0] / secs[1]);
+
+    free(args);
+    free(scratch);
+    free(starts);
+    free(text);
+}
@@ -0,0 +1,26 @@
+/*--------------------------------------------------------
+UNIX Shell Project
+function prototypes for tokenizer module: separa una línea de órdenes
+en argumentos respetando comillas y escapes
+
+Sistemas Operativos
+Grados I. Informatica, Computadores & Software
+Dept. Arquitectura de Computadores - UMA
+Iván Ballesteros Fernández - 24-25 - 2ºGCIA
+--------------------------------------------------------*/
+
+#ifndef _TOKENIZER_H
+#define _TOKENIZER_H
+
+#define TOK_ERR_QUOTE (-1) /* comillas sin cerrar */
+#define TOK_ERR_SUBST (-2) /* ${...} mal formado o $( sin cerrar */
+
+// -----------------------------------------------------------------------
+//      PUBLIC FUNCTIONS
+// -----------------------------------------------------------------------
+int tokenize_line(char *line, int length, char ***args, int *background, int *respawnable);
+const unsigned char * tokenize_literal(void);
+int tokenize_line_legacy(char *line, int length, char *args[], int *background, int *respawnable);
+void parse_bench(const char *path, int reps);
+
+#endif
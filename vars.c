@@ -0,0 +1,289 @@
+/*--------------------------------------------------------
+UNIX Shell Project
+vars module: variables del shell y entorno de los procesos lanzados
+
+Las variables se guardan en una tabla hash (FNV-1a, listas enlazadas por
+cubeta). Al arrancar se importa el entorno del shell con todas las
+variables exportadas. El vector envp con las exportadas se construye la
+primera vez que se pide después de un cambio y se reutiliza en todos los
+lanzamientos hasta el siguiente; se publica en environ, que es lo que
+usan execvp y getenv. Cada reconstrucción incrementa la generación, que
+el lanzador (zygote) usa para saber cuándo tiene que recibir el entorno.
+
+Los manejadores de SIGCHLD y SIGALRM también lanzan procesos, así que los
+cambios en la tabla y la reconstrucción se hacen con esas señales bloqueadas.
+
+Sistemas Operativos
+Grados I. Informatica, Computadores & Software
+Dept. Arquitectura de Computadores - UMA
+Iván Ballesteros Fernández - 24-25 - 2ºGCIA
+--------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include "vars.h"
+
+extern char **environ;
+
+// ----------- VARIABLE --------------------------------------------------
+typedef struct var_
+{
+	char * name;
+	char * value;
+	int exported;
+	unsigned hash;
+	struct var_ * next; /* siguiente en la misma cubeta */
+} var;
+
+static var **buckets = NULL;
+static unsigned nbuckets = 0;
+static unsigned nvars = 0;
+
+static char **envp = NULL;  /* vector publicado, un único bloque con las cadenas */
+static int env_dirty = 1;   /* hay cambios en las exportadas desde la última construcción */
+static unsigned generation = 0;
+static int last_status = 0; /* $? */
+static char status_buf[16];
+static char pid_buf[16];
+
+// -----------------------------------------------------------------------
+static unsigned hash_name(const char *name, size_t len)
+{
+    unsigned h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char) name[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void block_signals(sigset_t *old)
+{
+    sigset_t block;
+    sigemptyset(&block);
+    sigaddset(&block, SIGCHLD);
+    sigaddset(&block, SIGALRM);
+    sigprocmask(SIG_BLOCK, &block, old);
+}
+
+static var * find(const char *name, size_t len, unsigned h)
+{
+    if (nbuckets == 0) return NULL;
+    for (var *v = buckets[h & (nbuckets - 1)]; v; v = v->next) {
+        if (v->hash == h && strncmp(v->name, name, len) == 0 && v->name[len] == '\0') return v;
+    }
+    return NULL;
+}
+
+/* duplica el número de cubetas cuando hay más variables que cubetas */
+static void grow(void)
+{
+    unsigned n = nbuckets ? nbuckets * 2 : 64;
+    var **b = (var **) calloc(n, sizeof(var *));
+    if (b == NULL) return;
+    for (unsigned i = 0; i < nbuckets; i++) {
+        var *v = buckets[i];
+        while (v) {
+            var *next = v->next;
+            v->next = b[v->hash & (n - 1)];
+            b[v->hash & (n - 1)] = v;
+            v = next;
+        }
+    }
+    free(buckets);
+    buckets = b;
+    nbuckets = n;
+}
+
+// -----------------------------------------------------------------------
+/* 1 si name[0..len) es un nombre de variable válido */
+int var_valid_name(const char *name, size_t len)
+{
+    if (len == 0 || (name[0] >= '0' && name[0] <= '9')) return 0;
+    for (size_t i = 0; i < len; i++) {
+        char c = name[i];
+        if (!(c == '_' || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9'))) return 0;
+    }
+    return 1;
+}
+
+/* si word es NOMBRE=valor devuelve la longitud del nombre, si no 0 */
+int var_assignment(const char *word)
+{
+    const char *eq = strchr(word, '=');
+    if (eq == NULL || !var_valid_name(word, eq - word)) return 0;
+    return eq - word;
+}
+
+// -----------------------------------------------------------------------
+/* importa el entorno recibido por el shell */
+void vars_init(void)
+{
+    grow();
+    for (char **e = environ; *e; e++) {
+        char *eq = strchr(*e, '=');
+        if (eq == NULL || !var_valid_name(*e, eq - *e)) continue;
+        char *name = strndup(*e, eq - *e);
+        var_set(name, eq + 1, 1);
+        free(name);
+    }
+    snprintf(pid_buf, sizeof(pid_buf), "%d", getpid());
+}
+
+const char * var_lookup(const char *name, size_t len)
+{
+    if (len == 1 && name[0] == '?') {
+        snprintf(status_buf, sizeof(status_buf), "%d", last_status);
+        return status_buf;
+    }
+    if (len == 1 && name[0] == '$') return pid_buf;
+    var *v = find(name, len, hash_name(name, len));
+    return v ? v->value : NULL;
+}
+
+const char * var_get(const char *name)
+{
+    return var_lookup(name, strlen(name));
+}
+
+/* código de salida del último comando en primer plano ($?) */
+void vars_set_status(int status)
+{
+    last_status = status;
+}
+
+// -----------------------------------------------------------------------
+/* asigna value a name (value NULL conserva el valor actual). Con export
+   la variable pasa a exportarse; sin él conserva lo que tuviera.
+   devuelve 0 o -1 si el nombre no es válido */
+int var_set(const char *name, const char *value, int export)
+{
+    size_t len = strlen(name);
+    unsigned h = hash_name(name, len);
+    sigset_t old;
+
+    if (!var_valid_name(name, len)) return -1;
+    block_signals(&old);
+    var *v = find(name, len, h);
+    if (v == NULL) {
+        if (nvars >= nbuckets) grow();
+        v = (var *) malloc(sizeof(var));
+        v->name = strdup(name);
+        v->value = strdup(value ? value : "");
+        v->exported = 0;
+        v->hash = h;
+        v->next = buckets[h & (nbuckets - 1)];
+        buckets[h & (nbuckets - 1)] = v;
+        nvars++;
+    } else if (value != NULL && strcmp(v->value, value) != 0) {
+        free(v->value);
+        v->value = strdup(value);
+    } else if (!export || v->exported) {
+        sigprocmask(SIG_SETMASK, &old, NULL);
+        return 0; // sin cambios: el envp sigue valiendo
+    }
+    if (export) v->exported = 1;
+    if (v->exported) env_dirty = 1;
+    sigprocmask(SIG_SETMASK, &old, NULL);
+    return 0;
+}
+
+int var_unset(const char *name)
+{
+    size_t len = strlen(name);
+    unsigned h = hash_name(name, len);
+    sigset_t old;
+
+    if (!var_valid_name(name, len)) return -1;
+    if (nbuckets == 0) return 0;
+    block_signals(&old);
+    for (var **pv = &buckets[h & (nbuckets - 1)]; *pv; pv = &(*pv)->next) {
+        var *v = *pv;
+        if (v->hash == h && strcmp(v->name, name) == 0) {
+            *pv = v->next;
+            if (v->exported) env_dirty = 1;
+            free(v->name);
+            free(v->value);
+            free(v);
+            nvars--;
+            break;
+        }
+    }
+    sigprocmask(SIG_SETMASK, &old, NULL);
+    return 0;
+}
+
+// -----------------------------------------------------------------------
+/* devuelve el envp de las variables exportadas, reconstruyéndolo solo si
+   ha cambiado alguna desde la última vez */
+char ** vars_envp(void)
+{
+    sigset_t old;
+    if (!env_dirty) return envp;
+
+    block_signals(&old);
+    size_t count = 0, bytes = 0;
+    for (unsigned i = 0; i < nbuckets; i++) {
+        for (var *v = buckets[i]; v; v = v->next) {
+            if (!v->exported) continue;
+            count++;
+            bytes += strlen(v->name) + strlen(v->value) + 2;
+        }
+    }
+    // vector y cadenas en un solo bloque
+    char **e = (char **) malloc((count + 1) * sizeof(char *) + bytes);
+    if (e == NULL) {
+        sigprocmask(SIG_SETMASK, &old, NULL);
+        return envp;
+    }
+    char *p = (char *) (e + count + 1);
+    size_t k = 0;
+    for (unsigned i = 0; i < nbuckets; i++) {
+        for (var *v = buckets[i]; v; v = v->next) {
+            if (!v->exported) continue;
+            e[k++] = p;
+            p = stpcpy(stpcpy(stpcpy(p, v->name), "="), v->value) + 1;
+        }
+    }
+    e[k] = NULL;
+
+    free(envp);
+    envp = e;
+    environ = envp;
+    env_dirty = 0;
+    generation++;
+    sigprocmask(SIG_SETMASK, &old, NULL);
+    return envp;
+}
+
+unsigned vars_generation(void)
+{
+    vars_envp();
+    return generation;
+}
+
+// -----------------------------------------------------------------------
+static int cmp_var(const void *a, const void *b)
+{
+    return strcmp((*(var * const *) a)->name, (*(var * const *) b)->name);
+}
+
+/* lista las variables ordenadas por nombre (solo las exportadas si se pide) */
+void vars_print(int exported_only)
+{
+    var **all = (var **) malloc((nvars + 1) * sizeof(var *));
+    size_t n = 0;
+    for (unsigned i = 0; i < nbuckets; i++) {
+        for (var *v = buckets[i]; v; v = v->next) {
+            if (!exported_only || v->exported) all[n++] = v;
+        }
+    }
+    qsort(all, n, sizeof(var *), cmp_var);
+    for (size_t i = 0; i < n; i++) {
+        printf("%s%s='%s'\n", all[i]->exported ? "export " : "", all[i]->name, all[i]->value);
+    }
+    free(all);
+}
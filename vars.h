@@ -0,0 +1,32 @@
+/*--------------------------------------------------------
+UNIX Shell Project
+function prototypes for vars module: variables del shell y entorno
+de los procesos lanzados
+
+Sistemas Operativos
+Grados I. Informatica, Computadores & Software
+Dept. Arquitectura de Computadores - UMA
+Iván Ballesteros Fernández - 24-25 - 2ºGCIA
+--------------------------------------------------------*/
+
+#ifndef _VARS_H
+#define _VARS_H
+
+#include <stddef.h>
+
+// -----------------------------------------------------------------------
+//      PUBLIC FUNCTIONS
+// -----------------------------------------------------------------------
+void vars_init(void);
+const char * var_get(const char *name);
+const char * var_lookup(const char *name, size_t len);
+int var_set(const char *name, const char *value, int export);
+int var_unset(const char *name);
+int var_valid_name(const char *name, size_t len);
+int var_assignment(const char *word);
+void vars_set_status(int status);
+char ** vars_envp(void);
+unsigned vars_generation(void);
+void vars_print(int exported_only);
+
+#endif
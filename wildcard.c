@@ -0,0 +1,377 @@
+/*--------------------------------------------------------
+UNIX Shell Project
+wildcard module: expansión de *, ?, [...] y ** en los argumentos
+
+El patrón se recorre componente a componente. Los componentes sin
+comodines no leen el directorio; los demás comparan el patrón con el
+listado del directorio, que se guarda en una caché indexada por
+dispositivo e inodo y se da por bueno mientras el mtime no cambie.
+Un listado leído en el mismo segundo (o el siguiente) de su último
+cambio no se reutiliza: otra modificación en ese intervalo podría no
+cambiar el mtime.
+Como en bash, los nombres que empiezan por '.' solo encajan con un
+patrón que también empiece por '.', y ** no entra en enlaces simbólicos.
+Un carácter precedido de '\' es literal.
+
+Sistemas Operativos
+Grados I. Informatica, Computadores & Software
+Dept. Arquitectura de Computadores - UMA
+Iván Ballesteros Fernández - 24-25 - 2ºGCIA
+--------------------------------------------------------*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "wildcard.h"
+
+// ----------- LISTADO DE UN DIRECTORIO ---------------------------------
+typedef struct dir_entry_
+{
+	char * name;
+	unsigned char type; /* d_type de readdir */
+} dir_entry;
+
+typedef struct dir_listing_
+{
+	dev_t dev;
+	ino_t ino;
+	struct timespec mtime;  /* mtime del directorio al leerlo */
+	time_t read_at;         /* segundo (CLOCK_REALTIME) en que se leyó */
+	int n;
+	dir_entry * entries;    /* ordenadas por nombre; un bloque con las cadenas */
+	unsigned long used;     /* para desalojar el menos usado */
+	int pinned;             /* recorridos en curso que lo usan */
+	int temporary;          /* fuera de la caché: se libera al soltarlo */
+} dir_listing;
+
+static dir_listing cache[WILDCARD_CACHE_DIRS];
+static int ncached = 0;
+static unsigned long use_clock = 0;
+
+typedef struct results_
+{
+	char ** v;
+	int n, cap;
+} results;
+
+// -----------------------------------------------------------------------
+static int cmp_entry(const void *a, const void *b)
+{
+    return strcmp(((const dir_entry *) a)->name, ((const dir_entry *) b)->name);
+}
+
+/* lee el directorio dir en l. devuelve 0 o -1 */
+static int read_listing(const char *dir, dir_listing *l)
+{
+    DIR *d = opendir(dir);
+    if (d == NULL) return -1;
+
+    int n = 0, cap = 64;
+    size_t bytes = 0;
+    dir_entry *tmp = (dir_entry *) malloc(cap * sizeof(dir_entry));
+    struct dirent *de;
+    while ((de = readdir(d)) != NULL) {
+        if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0) continue;
+        if (n == cap) {
+            cap *= 2;
+            tmp = (dir_entry *) realloc(tmp, cap * sizeof(dir_entry));
+        }
+        tmp[n].name = strdup(de->d_name);
+        tmp[n].type = de->d_type;
+        bytes += strlen(de->d_name) + 1;
+        n++;
+    }
+    closedir(d);
+    qsort(tmp, n, sizeof(dir_entry), cmp_entry);
+
+    // vector y nombres en un solo bloque
+    l->entries = (dir_entry *) malloc(n * sizeof(dir_entry) + bytes);
+    char *p = (char *) (l->entries + n);
+    for (int i = 0; i < n; i++) {
+        l->entries[i].name = p;
+        l->entries[i].type = tmp[i].type;
+        p = stpcpy(p, tmp[i].name) + 1;
+        free(tmp[i].name);
+    }
+    free(tmp);
+    l->n = n;
+    return 0;
+}
+
+/* devuelve el listado de dir, de la caché si sigue siendo válido. Hay
+   que devolverlo con release_listing: mientras se recorre no se desaloja.
+   Si todas las entradas están en uso se devuelve una copia temporal */
+static dir_listing * get_listing(const char *dir)
+{
+    struct stat st;
+    struct timespec now;
+    dir_listing *l = NULL, *lru = NULL;
+
+    if (stat(dir, &st) == -1 || !S_ISDIR(st.st_mode)) return NULL;
+    for (int i = 0; i < ncached; i++) {
+        if (cache[i].n >= 0 && cache[i].dev == st.st_dev && cache[i].ino == st.st_ino) l = &cache[i];
+        else if (cache[i].pinned == 0 && (lru == NULL || cache[i].used < lru->used)) lru = &cache[i];
+    }
+    if (l != NULL && l->mtime.tv_sec == st.st_mtim.tv_sec && l->mtime.tv_nsec == st.st_mtim.tv_nsec &&
+        l->read_at > st.st_mtim.tv_sec + 1) {
+        l->used = ++use_clock;
+        l->pinned++;
+        return l;
+    }
+
+    if (l != NULL && l->pinned > 0) l = NULL; // caducado pero en uso: copia temporal
+    else if (l == NULL && ncached < WILDCARD_CACHE_DIRS) l = &cache[ncached++];
+    else if (l == NULL) l = lru;
+
+    if (l == NULL) {
+        l = (dir_listing *) calloc(1, sizeof(dir_listing));
+        l->temporary = 1;
+    }
+    free(l->entries); // listado caducado o desalojado (NULL en una entrada nueva)
+    l->entries = NULL;
+    l->n = -1;        // no válido hasta terminar la lectura
+    l->dev = st.st_dev;
+    l->ino = st.st_ino;
+    l->mtime = st.st_mtim;
+    clock_gettime(CLOCK_REALTIME, &now);
+    l->read_at = now.tv_sec;
+    l->used = ++use_clock;
+    if (read_listing(dir, l) == -1) {
+        if (l->temporary) free(l);
+        return NULL;
+    }
+    l->pinned++;
+    return l;
+}
+
+static void release_listing(dir_listing *l)
+{
+    if (l->temporary) {
+        free(l->entries);
+        free(l);
+    } else {
+        l->pinned--;
+    }
+}
+
+// -----------------------------------------------------------------------
+/* p apunta a '['. devuelve 1 o 0 según c esté o no en la clase y deja en
+   *end lo que sigue a ']'. -1 si la clase no se cierra ('[' literal) */
+static int match_class(const char *p, char c, const char **end)
+{
+    int neg = 0, found = 0;
+    p++;
+    if (*p == '!' || *p == '^') {
+        neg = 1;
+        p++;
+    }
+    const char *start = p;
+    while (*p && (*p != ']' || p == start)) { // ']' justo al principio es literal
+        unsigned char lo = *p, hi;
+        if (lo == '\\' && p[1]) lo = *++p;
+        hi = lo;
+        if (p[1] == '-' && p[2] && p[2] != ']') {
+            p += 2;
+            hi = *p;
+            if (hi == '\\' && p[1]) hi = *++p;
+        }
+        if ((unsigned char) c >= lo && (unsigned char) c <= hi) found = 1;
+        p++;
+    }
+    if (*p != ']') return -1;
+    *end = p + 1;
+    return found != neg;
+}
+
+/* 1 si el nombre s encaja con el componente p */
+static int match(const char *p, const char *s)
+{
+    const char *star_p = NULL, *star_s = NULL; // último '*' para retroceder
+
+    while (*s) {
+        const char *next;
+        int r;
+        if (*p == '*') {
+            star_p = ++p;
+            star_s = s;
+            continue;
+        }
+        if (*p == '?') {
+            p++;
+            s++;
+            continue;
+        }
+        if (*p == '[' && (r = match_class(p, *s, &next)) >= 0) {
+            if (r) {
+                p = next;
+                s++;
+                continue;
+            }
+        } else if (*p == '\\' && p[1]) {
+            if (p[1] == *s) {
+                p += 2;
+                s++;
+                continue;
+            }
+        } else if (*p && *p == *s) {
+            p++;
+            s++;
+            continue;
+        }
+        if (star_p == NULL) return 0;
+        p = star_p; // el '*' absorbe un carácter más
+        s = ++star_s;
+    }
+    while (*p == '*') p++;
+    return *p == '\0';
+}
+
+/* 1 si s tiene algún *, ? o [ sin escapar */
+static int has_meta(const char *s)
+{
+    for (; *s; s++) {
+        if (*s == '\\' && s[1]) s++;
+        else if (*s == '*' || *s == '?' || *s == '[') return 1;
+    }
+    return 0;
+}
+
+/* quita los '\' de escape. devuelve la nueva longitud */
+int wildcard_unescape(char *s)
+{
+    char *start = s, *w = s;
+    for (; *s; s++) {
+        if (*s == '\\' && s[1]) s++;
+        *w++ = *s;
+    }
+    *w = '\0';
+    return w - start;
+}
+
+// -----------------------------------------------------------------------
+static void add_result(results *res, const char *path, int dir_slash)
+{
+    if (res->n == res->cap) {
+        res->cap = res->cap ? res->cap * 2 : 16;
+        res->v = (char **) realloc(res->v, res->cap * sizeof(char *));
+    }
+    size_t len = strlen(path);
+    char *s = (char *) malloc(len + 2);
+    memcpy(s, path, len);
+    if (dir_slash) s[len++] = '/';
+    s[len] = '\0';
+    res->v[res->n++] = s;
+}
+
+/* 1 si path es un directorio. Con ** no se sigue un enlace simbólico */
+static int is_dir(const char *path, unsigned char type, int follow_links)
+{
+    struct stat st;
+    if (type == DT_DIR) return 1;
+    if (type != DT_UNKNOWN && !(type == DT_LNK && follow_links)) return 0;
+    if ((follow_links ? stat(path, &st) : lstat(path, &st)) == -1) return 0;
+    return S_ISDIR(st.st_mode);
+}
+
+static int hidden_ok(const char *comp, const char *name)
+{
+    return name[0] != '.' || comp[0] == '.' || (comp[0] == '\\' && comp[1] == '.');
+}
+
+/* añade a res lo que encaje con comps[idx..] debajo de path (len bytes,
+   vacío o terminado en '/') */
+static void walk(char *path, size_t len, char **comps, int ncomps, int idx, int dirs_only, results *res)
+{
+    const char *comp = comps[idx];
+    int last = (idx == ncomps - 1);
+    int globstar = strcmp(comp, "**") == 0;
+
+    if (!globstar && !has_meta(comp)) { // literal: no hace falta leer el directorio
+        char name[NAME_MAX + 1];
+        struct stat st;
+        if (strlen(comp) > NAME_MAX || len + strlen(comp) + 2 > PATH_MAX) return;
+        strcpy(name, comp);
+        wildcard_unescape(name);
+        size_t nlen = stpcpy(path + len, name) - (path + len);
+        if (!last) {
+            strcpy(path + len + nlen, "/");
+            walk(path, len + nlen + 1, comps, ncomps, idx + 1, dirs_only, res);
+        } else if (lstat(path, &st) == 0 && (!dirs_only || is_dir(path, DT_UNKNOWN, 1))) {
+            add_result(res, path, dirs_only);
+        }
+        path[len] = '\0';
+        return;
+    }
+
+    if (globstar && !last) walk(path, len, comps, ncomps, idx + 1, dirs_only, res); // cero directorios
+
+    dir_listing *l = get_listing(len ? path : ".");
+    if (l == NULL) return;
+    for (int i = 0; i < l->n; i++) {
+        const char *name = l->entries[i].name;
+        size_t nlen = strlen(name);
+        if (globstar ? name[0] == '.' : !hidden_ok(comp, name)) continue;
+        if (!globstar && !match(comp, name)) continue;
+        if (len + nlen + 2 > PATH_MAX) continue;
+        memcpy(path + len, name, nlen + 1);
+
+        if (globstar) { // ** al final: todo lo que hay debajo; si no, baja y sigue con **
+            int dir = is_dir(path, l->entries[i].type, 0);
+            if (last && (!dirs_only || dir)) add_result(res, path, dirs_only);
+            if (dir) {
+                strcpy(path + len + nlen, "/");
+                walk(path, len + nlen + 1, comps, ncomps, idx, dirs_only, res);
+            }
+        } else if (last) {
+            if (!dirs_only || is_dir(path, l->entries[i].type, 1)) add_result(res, path, dirs_only);
+        } else if (is_dir(path, l->entries[i].type, 1)) {
+            strcpy(path + len + nlen, "/");
+            walk(path, len + nlen + 1, comps, ncomps, idx + 1, dirs_only, res);
+        }
+        path[len] = '\0';
+    }
+    release_listing(l);
+}
+
+static int cmp_str(const void *a, const void *b)
+{
+    return strcmp(*(char * const *) a, *(char * const *) b);
+}
+
+// -----------------------------------------------------------------------
+/* expande pattern. devuelve el número de rutas (ordenadas) que encajan y
+   las deja en *matches, que hay que liberar con wildcard_free */
+int wildcard_expand(const char *pattern, char ***matches)
+{
+    char pat[PATH_MAX], path[PATH_MAX];
+    char *comps[PATH_MAX / 2];
+    int ncomps = 0, dirs_only = 0;
+    size_t len = 0;
+    results res = { NULL, 0, 0 };
+
+    *matches = NULL;
+    if (strlen(pattern) >= sizeof(pat)) return 0;
+    strcpy(pat, pattern);
+    if (pat[0] == '/') path[len++] = '/';
+    path[len] = '\0';
+
+    for (char *tok = strtok(pat, "/"); tok; tok = strtok(NULL, "/")) comps[ncomps++] = tok;
+    if (ncomps == 0) return 0;
+    dirs_only = pattern[strlen(pattern) - 1] == '/';
+
+    walk(path, len, comps, ncomps, 0, dirs_only, &res);
+    qsort(res.v, res.n, sizeof(char *), cmp_str);
+    *matches = res.v;
+    return res.n;
+}
+
+void wildcard_free(char **matches, int n)
+{
+    for (int i = 0; i < n; i++) free(matches[i]);
+    free(matches);
+}
@@ -0,0 +1,24 @@
+/*--------------------------------------------------------
+UNIX Shell Project
+function prototypes for wildcard module: expansión de *, ?, [...] y **
+en los argumentos
+
+Sistemas Operativos
+Grados I. Informatica, Computadores & Software
+Dept. Arquitectura de Computadores - UMA
+Iván Ballesteros Fernández - 24-25 - 2ºGCIA
+--------------------------------------------------------*/
+
+#ifndef _WILDCARD_H
+#define _WILDCARD_H
+
+#define WILDCARD_CACHE_DIRS 128 /* listados de directorio guardados como máximo */
+
+// -----------------------------------------------------------------------
+//      PUBLIC FUNCTIONS
+// -----------------------------------------------------------------------
+int wildcard_expand(const char *pattern, char ***matches);
+void wildcard_free(char **matches, int n);
+int wildcard_unescape(char *s);
+
+#endif
@@ -0,0 +1,310 @@
+/*--------------------------------------------------------
+UNIX Shell Project
+zygote module: lanzador precalentado
+
+El shell arranca una copia de sí mismo con ZYGOTE_ARG (exec, así que solo
+tiene el binario y la libc mapeados, no el heap del shell) y le envía las
+peticiones de lanzamiento por un socketpair. El lanzador crea el hijo con
+clone(CLONE_PARENT), de modo que el hijo es hijo del shell: SIGCHLD,
+waitpid y setpgid funcionan igual que si el shell hubiera hecho fork.
+
+Sistemas Operativos
+Grados I. Informatica, Computadores & Software
+Dept. Arquitectura de Computadores - UMA
+Iván Ballesteros Fernández - 24-25 - 2ºGCIA
+--------------------------------------------------------*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include "job_control.h"
+#include "zygote.h"
+#include "vars.h"
+
+// ----------- CABECERA DE UNA PETICIÓN ---------------------------------
+// va seguida de las cadenas cwd, argv[0..argc-1], las rutas de las
+// redirecciones que tengan (en orden) y, si envc >= 0, las envc cadenas
+// del entorno, todas terminadas en '\0'
+typedef struct zygote_req_
+{
+	launch_opts opts;
+	redir_list redirs; /* los punteros path no son válidos en el lanzador */
+	int argc;
+	int envc;          /* -1: el entorno no ha cambiado desde la última petición */
+} zygote_req;
+
+static int zsock = -1; // extremo del shell del socketpair, -1 si no hay lanzador
+static pid_t zpid = 0; // pid del lanzador mientras no se haya recogido
+static unsigned zenv_gen = 0; // generación del entorno que tiene el lanzador
+
+// -----------------------------------------------------------------------
+/* arranca el lanzador. devuelve 0 si queda activo */
+int zygote_start(void)
+{
+    int sv[2];
+    char exe[PATH_MAX];
+    char fd[16];
+
+    if (zsock >= 0) return 0;
+    ssize_t len = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+    if (len < 0) {
+        perror("zygote: readlink");
+        return -1;
+    }
+    exe[len] = '\0';
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sv) == -1) {
+        perror("zygote: socketpair");
+        return -1;
+    }
+
+    block_SIGCHLD();
+    pid_t pid = fork();
+    if (pid == 0) {
+        snprintf(fd, sizeof(fd), "%d", sv[1]);
+        fcntl(sv[1], F_SETFD, 0); // sin CLOEXEC para que llegue al lanzador
+        restore_child_nofile();   // sus hijos lo heredan (jobtop lo sube solo para el shell)
+        execl(exe, exe, ZYGOTE_ARG, fd, (char *) NULL);
+        _exit(127);
+    }
+    close(sv[1]);
+    if (pid < 0) {
+        perror("zygote: fork");
+        close(sv[0]);
+        unblock_SIGCHLD();
+        return -1;
+    }
+    zsock = sv[0];
+    zpid = pid;
+    zenv_gen = 0; // se le envía el entorno con la primera petición
+    unblock_SIGCHLD();
+    return 0;
+}
+
+// -----------------------------------------------------------------------
+/* al cerrar el socket el lanzador recibe EOF y termina */
+void zygote_stop(void)
+{
+    if (zsock < 0) return;
+    close(zsock);
+    zsock = -1;
+}
+
+int zygote_running(void)
+{
+    return zsock >= 0;
+}
+
+pid_t zygote_pid(void)
+{
+    return zpid;
+}
+
+/* sigchld_handler ha recogido al lanzador */
+void zygote_exited(void)
+{
+    zygote_stop();
+    zpid = 0;
+}
+
+// -----------------------------------------------------------------------
+static char * put_string(char *p, const char *end, const char *s)
+{
+    size_t len = strlen(s) + 1;
+    if (p == NULL || p + len > end) return NULL;
+    memcpy(p, s, len);
+    return p + len;
+}
+
+// -----------------------------------------------------------------------
+/* pide al lanzador que ejecute argv. devuelve el pid del hijo o -1 (en
+   ese caso el lanzador se desactiva y spawn_job recurre a fork) */
+pid_t zygote_spawn(char **argv, const launch_opts *opts, const redir_list *redirs)
+{
+    static char buf[ZYGOTE_MSG];
+    char cwd[PATH_MAX];
+    zygote_req *req = (zygote_req *) buf;
+    char *p = buf + sizeof(zygote_req), *end = buf + sizeof(buf);
+    pid_t pid = -1;
+    unsigned gen = vars_generation();
+
+    if (getcwd(cwd, sizeof(cwd)) == NULL) return -1;
+    if (opts) req->opts = *opts;
+    else init_launch_opts(&req->opts);
+    if (redirs) req->redirs = *redirs;
+    else req->redirs.n = 0;
+    p = put_string(p, end, cwd);
+    for (req->argc = 0; argv[req->argc]; req->argc++) p = put_string(p, end, argv[req->argc]);
+    for (int i = 0; i < req->redirs.n; i++) {
+        if (req->redirs.ops[i].path) p = put_string(p, end, req->redirs.ops[i].path);
+    }
+    req->envc = -1;
+    if (gen != zenv_gen) { // el entorno solo viaja cuando cambia
+        char **envp = vars_envp();
+        for (req->envc = 0; envp[req->envc]; req->envc++) p = put_string(p, end, envp[req->envc]);
+    }
+    if (p == NULL) return -1; // no cabe: se lanza con fork
+
+    // el socket se comparte entre el bucle principal y los manejadores
+    // que relanzan procesos: la petición y su respuesta no se pueden intercalar
+    sigset_t block, old;
+    sigemptyset(&block);
+    sigaddset(&block, SIGCHLD);
+    sigaddset(&block, SIGALRM);
+    sigprocmask(SIG_BLOCK, &block, &old);
+    // MSG_NOSIGNAL: si el lanzador ha muerto, EPIPE en lugar de un SIGPIPE que mataría al shell
+    if (send(zsock, buf, p - buf, MSG_NOSIGNAL) < 0 || recv(zsock, &pid, sizeof(pid), 0) != sizeof(pid)) {
+        fprintf(stderr, "zygote: el lanzador no responde, se usa fork\n");
+        zygote_stop();
+        pid = -1;
+    } else {
+        if (req->envc >= 0) zenv_gen = gen;
+        if (pid < 0) { // el lanzador no pudo entrar en el directorio: se lanza con fork desde el shell
+            fprintf(stderr, "zygote: %s: %s\n", cwd, strerror(-pid));
+            pid = -1;
+        }
+    }
+    sigprocmask(SIG_SETMASK, &old, NULL);
+    return pid;
+}
+
+// -----------------------------------------------------------------------
+/* bucle del proceso lanzador. no retorna */
+int zygote_serve(int sock)
+{
+    static char buf[ZYGOTE_MSG];
+    char last_cwd[PATH_MAX] = "";
+    char *argv[ZYGOTE_MSG / 2];
+    char **envp = NULL; // último entorno recibido (vector y cadenas en un bloque)
+    sigset_t empty;
+
+    new_process_group(0); // fuera del grupo del shell: ctrl+c no debe matarlo
+    ignore_terminal_signals();
+    sigemptyset(&empty);
+    sigprocmask(SIG_SETMASK, &empty, NULL);
+
+    for (;;) {
+        ssize_t n = recv(sock, buf, sizeof(buf), 0);
+        if (n <= 0) exit(0); // el shell ha cerrado el socket
+
+        zygote_req *req = (zygote_req *) buf;
+        char *p = buf + sizeof(zygote_req);
+        char *cwd = p;
+        p += strlen(p) + 1;
+        for (int i = 0; i < req->argc; i++) {
+            argv[i] = p;
+            p += strlen(p) + 1;
+        }
+        argv[req->argc] = NULL;
+        for (int i = 0; i < req->redirs.n; i++) {
+            if (req->redirs.ops[i].path) {
+                req->redirs.ops[i].path = p;
+                p += strlen(p) + 1;
+            }
+        }
+        if (req->envc >= 0) { // entorno nuevo: se copia porque buf se reutiliza
+            size_t bytes = buf + n - p;
+            char **e = (char **) malloc((req->envc + 1) * sizeof(char *) + bytes);
+            if (e != NULL) {
+                char *s = memcpy(e + req->envc + 1, p, bytes);
+                for (int i = 0; i < req->envc; i++) {
+                    e[i] = s;
+                    s += strlen(s) + 1;
+                }
+                e[req->envc] = NULL;
+                environ = e;
+                free(envp);
+                envp = e;
+            }
+        }
+
+        // el directorio se cambia en el lanzador y lo heredan los hijos; si
+        // no se puede se responde -errno y el shell lanza con fork
+        if (strcmp(cwd, last_cwd) != 0) {
+            if (strlen(cwd) >= sizeof(last_cwd) || chdir(cwd) == -1) {
+                pid_t err = (strlen(cwd) >= sizeof(last_cwd)) ? -ENAMETOOLONG : -errno;
+                last_cwd[0] = '\0'; // ya no se sabe en qué directorio está
+                send(sock, &err, sizeof(err), MSG_NOSIGNAL);
+                continue;
+            }
+            strcpy(last_cwd, cwd);
+        }
+
+        pid_t pid = syscall(SYS_clone, CLONE_PARENT | SIGCHLD, 0, NULL, NULL, 0);
+        if (pid == 0) {
+            close(sock);
+            exec_child(argv, &req->opts, &req->redirs);
+        }
+        send(sock, &pid, sizeof(pid), MSG_NOSIGNAL);
+    }
+}
+
+// -----------------------------------------------------------------------
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+static double now_us(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+}
+
+// -----------------------------------------------------------------------
+/* lanza n veces argv con fork desde el shell y n veces con el lanzador e
+   imprime p50/p99 del tiempo hasta tener el pid y hasta que el hijo termina */
+void zygote_bench(int n, char **argv)
+{
+    int started = 0;
+    if (!zygote_running()) {
+        if (zygote_start() == -1) return;
+        started = 1;
+    }
+    double *spawn = (double *) malloc(n * sizeof(double));
+    double *total = (double *) malloc(n * sizeof(double));
+    int devnull = open("/dev/null", O_WRONLY);
+    int saved_out = dup(STDOUT_FILENO);
+    block_SIGCHLD(); // los hijos se recogen aquí, no en sigchld_handler
+    dup2(devnull, STDOUT_FILENO);
+    for (int mode = 0; mode < 2; mode++) {
+        int ok = 0;
+        for (int i = 0; i < n; i++) {
+            double t0 = now_us(), t1;
+            pid_t pid;
+            if (mode == 0) {
+                pid = fork();
+                if (pid == 0) exec_child(argv, NULL, NULL);
+            } else {
+                pid = zygote_spawn(argv, NULL, NULL);
+            }
+            t1 = now_us();
+            if (pid < 0 || waitpid(pid, NULL, 0) < 0) break;
+            spawn[ok] = t1 - t0;
+            total[ok] = now_us() - t0;
+            ok++;
+        }
+        qsort(spawn, ok, sizeof(double), cmp_double);
+        qsort(total, ok, sizeof(double), cmp_double);
+        if (ok > 0) {
+            dprintf(saved_out, "%-7s n=%d  pid: p50 %8.1f us  p99 %8.1f us   exit: p50 %8.1f us  p99 %8.1f us\n",
+                    mode ? "zygote" : "fork", ok, spawn[ok / 2], spawn[(ok * 99) / 100],
+                    total[ok / 2], total[(ok * 99) / 100]);
+        }
+    }
+    dup2(saved_out, STDOUT_FILENO);
+    close(saved_out);
+    close(devnull);
+    unblock_SIGCHLD();
+    if (started) zygote_stop();
+    free(spawn);
+    free(total);
+}
@@ -0,0 +1,32 @@
+/*--------------------------------------------------------
+UNIX Shell Project
+function prototypes for zygote module: proceso lanzador que hace el
+fork/exec en lugar del shell
+
+Sistemas Operativos
+Grados I. Informatica, Computadores & Software
+Dept. Arquitectura de Computadores - UMA
+Iván Ballesteros Fernández - 24-25 - 2ºGCIA
+--------------------------------------------------------*/
+
+#ifndef _ZYGOTE_H
+#define _ZYGOTE_H
+
+#include "launch.h"
+
+#define ZYGOTE_ARG "--zygote" /* argv[1] con el que el shell arranca como lanzador */
+#define ZYGOTE_MSG 65536      /* tamaño máximo de una petición */
+
+// -----------------------------------------------------------------------
+//      PUBLIC FUNCTIONS
+// -----------------------------------------------------------------------
+int zygote_start(void);
+void zygote_stop(void);
+int zygote_running(void);
+pid_t zygote_pid(void);
+void zygote_exited(void);
+pid_t zygote_spawn(char **argv, const launch_opts *opts, const redir_list *redirs);
+int zygote_serve(int sock);
+void zygote_bench(int n, char **argv);
+
+#endif